@@ -0,0 +1,373 @@
+#define _GNU_SOURCE
+#define _BatchWidth_ 8
+#define _GridTolerance_ 1.0e-9
+#define _BatchBlock_ (1 << 16)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "nx1dInterpolator.h"
+#include "nx1dIO.h"
+
+/* Batch interpolation:
+//{{{
+    Families of surfaces (e.g. one potential per electronic state) share the
+    same grid. Instead of one process per surface, the batch file lists the
+    surfaces as "inputfile outputfile" pairs, one per line (# comments and
+    blank lines are skipped), and all of them are interpolated by one plan.
+
+    The surfaces are processed in groups of up to _BatchWidth_ surfaces. The
+    values of the surfaces of a group are interleaved into a grid with
+    n_values = width values per point, so every solve of the plan handles
+    the right hand sides of the whole group in the SIMD lanes, also in the
+    pass over the last dimension, which a single surface only vectorizes
+    along its line. The plan, the interleaved grids and the per surface
+    buffers are set up once and reused for all groups; the input files of a
+    group are read and the output files written concurrently. A surface is
+    separated from the interleaved result _BatchBlock_ points at a time while
+    it is written, so the output needs no full size copy per surface.
+
+    The grid of the first surface defines nq, origin and dq, every other
+    surface is checked against it. Unused lanes of the last group are zero.
+//}}}*/
+typedef struct BatchSlot {
+    double ** q;            // coordinate arrays of a text input
+    double  * v;            // values of the surface (text input)
+    double  * values;       // values of the surface (text or binary input)
+    double  * out;          // block of the interpolated surface
+    int     * nq;
+    double  * origin;
+    double    dq;
+    size_t    n_points;
+    BinaryMap map;
+} BatchSlot;
+
+// Internal prototypes
+static int  ReadBatchFile(char *batchfile, char ***inputfile, char ***outputfile);
+static void ReadSurface(BatchSlot *slot, char *inputfile, int dimension);
+static int  SameGrid(const BatchSlot *a, const BatchSlot *b, int dimension);
+
+
+int nx1dBatchInterpolation(char *batchfile, int dimension, int n_spline, int n_threads, int engine,
+                           char *order_list, int binary_out, int text_flags){
+
+    int i, s, first;
+    int n_files, n_group;
+    int width;
+    size_t n_points  = 0;
+    size_t nn_points = 0;
+    size_t p, i_block, n_block;
+    int fd, failed;
+    int * nq_new = NULL;
+    char ** inputfile  = NULL;
+    char ** outputfile = NULL;
+    double * v  = NULL;
+    double * yy = NULL;
+    BatchSlot * slot = NULL;
+    BatchSlot reference;
+    TextWriter * writer = NULL;
+    nx1dPlan * plan = NULL;
+
+#ifdef _OPENMP
+    int n_io = (n_threads > 0) ? n_threads : omp_get_max_threads();
+#endif
+
+    n_files = ReadBatchFile(batchfile, &inputfile, &outputfile);
+    width   = (n_files < _BatchWidth_) ? n_files : _BatchWidth_;
+
+    slot   = calloc(width, sizeof(BatchSlot));
+    nq_new = malloc(dimension * sizeof(int));
+    if(slot == NULL || nq_new == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "batch slots");
+        exit(2);
+    }
+    for(s = 0; s < width; ++s){
+        slot[s].q      = calloc(dimension, sizeof(double*));
+        slot[s].nq     = calloc(dimension, sizeof(int));
+        slot[s].origin = calloc(dimension, sizeof(double));
+        if(slot[s].q == NULL || slot[s].nq == NULL || slot[s].origin == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "batch slots");
+            exit(2);
+        }
+    }
+    memset(&reference, 0, sizeof(BatchSlot));
+
+    for(first = 0; first < n_files; first += width){
+
+        n_group = (n_files - first < width) ? n_files - first : width;
+
+    // read the surfaces of the group concurrently
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic) num_threads(n_io)
+        #endif
+        for(s = 0; s < n_group; ++s){
+            ReadSurface(&slot[s], inputfile[first + s], dimension);
+        }
+
+    // the first surface defines the grid
+        if(plan == NULL){
+            reference = slot[0];
+            reference.nq     = malloc(dimension * sizeof(int));
+            reference.origin = malloc(dimension * sizeof(double));
+            if(reference.nq == NULL || reference.origin == NULL){
+                fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "grid arrays");
+                exit(2);
+            }
+            memcpy(reference.nq, slot[0].nq, dimension * sizeof(int));
+            memcpy(reference.origin, slot[0].origin, dimension * sizeof(double));
+        }
+        for(s = 0; s < n_group; ++s){
+            if(!SameGrid(&slot[s], &reference, dimension)){
+                fprintf(stderr,
+                    "\n(-) ERROR in batch file \"%s\":"
+                    "\n    The grid of \"%s\" differs from the grid of \"%s\"."
+                    "\n    Aborting - please check your input..."
+                    "\n\n"
+                    , batchfile, inputfile[first + s], inputfile[0]
+                );
+                exit(1);
+            }
+        }
+
+    // plan and interleaved grids are set up once for all groups
+        if(plan == NULL){
+            n_points = reference.n_points;
+            CheckPlanError(nx1dPlanCreate(&plan, reference.nq, reference.dq, dimension, n_spline, width));
+            SetupPlan(plan, dimension, n_threads, engine, order_list);
+            nn_points = nx1dPlanPoints(plan, nq_new);
+
+            v  = malloc(n_points * width * sizeof(double));
+            yy = nx1dPlanAlloc(plan, nn_points * width * sizeof(double));
+            if(v == NULL || yy == NULL){
+                fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "interpolated data");
+                exit(2);
+            }
+            for(s = 0; s < width; ++s){
+                slot[s].out = malloc(_BatchBlock_ * sizeof(double));
+                if(slot[s].out == NULL){
+                    fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "interpolated data");
+                    exit(2);
+                }
+            }
+        }
+
+    // interleave the surfaces, value s of a point belongs to surface s
+        #ifdef _OPENMP
+        #pragma omp parallel for private(s) num_threads(n_io)
+        #endif
+        for(p = 0; p < n_points; ++p){
+            for(s = 0; s < width; ++s){
+                v[p * width + s] = (s < n_group) ? slot[s].values[p] : 0.0;
+            }
+        }
+        for(s = 0; s < n_group; ++s){
+            BinaryInputRelease(&slot[s].map);
+        }
+
+        CheckPlanError(nx1dPlanExecute(plan, v, yy));
+
+    // separate and write the interpolated surfaces concurrently
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic) private(p, i_block, n_block, fd, failed, writer) num_threads(n_io)
+        #endif
+        for(s = 0; s < n_group; ++s){
+            fd = -1;
+            failed = 0;
+            writer = NULL;
+            if(binary_out || IsBinaryFile(outputfile[first + s])){
+                fd = BinaryOutputOpen(outputfile[first + s], nq_new, reference.origin,
+                                      reference.dq / (double)(n_spline + 1), n_spline, dimension, 1);
+            }else{
+                writer = TextOutputOpen(outputfile[first + s], nq_new, reference.origin,
+                                        reference.dq / (double)(n_spline + 1), dimension, 1, text_flags);
+            }
+            for(i_block = 0; i_block < nn_points && !failed; i_block += n_block){
+                n_block = (nn_points - i_block < _BatchBlock_) ? nn_points - i_block : _BatchBlock_;
+                for(p = 0; p < n_block; ++p){
+                    slot[s].out[p] = yy[(i_block + p) * width + s];
+                }
+                if(writer == NULL){
+                    failed = BinaryOutputBlock(fd, slot[s].out, n_block, -1);
+                }else{
+                    TextOutputWrite(writer, slot[s].out, n_block);
+                }
+            }
+            if(writer == NULL){
+                BinaryOutputClose(fd, outputfile[first + s], failed);
+            }else{
+                TextOutputClose(writer);
+            }
+        }
+    }
+
+    nx1dPlanDestroy(plan);
+    for(s = 0; s < width; ++s){
+        for(i = 0; i < dimension; ++i){
+            free(slot[s].q[i]);
+        }
+        free(slot[s].q);
+        free(slot[s].v);
+        free(slot[s].out);
+        free(slot[s].nq);
+        free(slot[s].origin);
+    }
+    for(i = 0; i < n_files; ++i){
+        free(inputfile[i]);
+        free(outputfile[i]);
+    }
+    free(inputfile);
+    free(outputfile);
+    free(reference.nq);
+    free(reference.origin);
+    free(slot);
+    free(nq_new);
+    free(v);
+    nx1dFree(yy);
+
+    return n_files;
+}
+
+
+// Read the "inputfile outputfile" pairs of the batch file, returns the
+//  number of pairs
+static int ReadBatchFile(char *batchfile, char ***inputfile, char ***outputfile){
+
+    int n, capacity, line;
+    size_t length = 0;
+    char * buffer = NULL;
+    char * input  = NULL;
+    char * output = NULL;
+    char * save   = NULL;
+    char ** aux   = NULL;
+    FILE * fp = NULL;
+
+    fp = fopen(batchfile, "r");
+    if(fp == NULL){
+        fprintf(stderr,
+            "\n(-) ERROR opening batch-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , batchfile
+        );
+        exit(1);
+    }
+
+    for(n = 0, capacity = 0, line = 1; getline(&buffer, &length, fp) > 0; ++line){
+
+    // strip comments and skip blank lines
+        buffer[strcspn(buffer, "#%")] = '\0';
+        input = strtok_r(buffer, " \t\r\n", &save);
+        if(input == NULL) continue;
+        output = strtok_r(NULL, " \t\r\n", &save);
+        if(output == NULL){
+            fprintf(stderr,
+                "\n(-) ERROR reading data from batch-file \"%s\"."
+                "\n    Line %d doesn't list an input and an output file."
+                "\n    Aborting - please check your input..."
+                "\n\n"
+                , batchfile, line
+            );
+            exit(1);
+        }
+
+        if(n == capacity){
+            capacity = (capacity > 0) ? 2 * capacity : 64;
+            aux = realloc((*inputfile), capacity * sizeof(char*));
+            if(aux != NULL) (*inputfile) = aux;
+            aux = (aux != NULL) ? realloc((*outputfile), capacity * sizeof(char*)) : NULL;
+            if(aux == NULL){
+                fprintf(stderr, "\n(-) ERROR in reallocation of %s\n    Aborting...\n\n", "batch list");
+                exit(2);
+            }
+            (*outputfile) = aux;
+        }
+        (*inputfile)[n]  = strdup(input);
+        (*outputfile)[n] = strdup(output);
+        if((*inputfile)[n] == NULL || (*outputfile)[n] == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "batch list");
+            exit(2);
+        }
+        ++n;
+    }
+    free(buffer);
+    fclose(fp);
+
+    if(n == 0){
+        fprintf(stderr,
+            "\n(-) ERROR reading data from batch-file \"%s\"."
+            "\n    The file doesn't list any surface."
+            "\n    Aborting - please check your input..."
+            "\n\n"
+            , batchfile
+        );
+        exit(1);
+    }
+
+    return n;
+}
+
+
+// Read a single valued surface into slot, text inputs reuse the
+//  arrays of the slot, binary inputs are mapped
+static void ReadSurface(BatchSlot *slot, char *inputfile, int dimension){
+
+    int i, n_spline, n_values;
+
+    if(IsBinaryFile(inputfile)){
+        slot->n_points = BinaryInputFunction(inputfile, &slot->map, slot->nq, slot->origin, &slot->dq,
+                                             &n_spline, &n_values, &slot->values, dimension);
+        if(n_values != 1){
+            fprintf(stderr,
+                "\n(-) ERROR reading data from input-file \"%s\"."
+                "\n    Batch mode requires a single value per point, the file holds %d."
+                "\n    Aborting - please check your input..."
+                "\n\n"
+                , inputfile, n_values
+            );
+            exit(1);
+        }
+        return;
+    }
+
+    slot->n_points = InputFunction(inputfile, &slot->q, slot->nq, &slot->v, dimension, 1);
+    slot->values   = slot->v;
+    if(slot->n_points < 2){
+        fprintf(stderr,
+            "\n(-) ERROR reading data from input-file \"%s\"."
+            "\n    The file contains less than two points."
+            "\n    Aborting - please check your input..."
+            "\n\n"
+            , inputfile
+        );
+        exit(1);
+    }
+    slot->dq = slot->q[dimension-1][1] - slot->q[dimension-1][0];
+    for(i = 0; i < dimension; ++i){
+        slot->origin[i] = slot->q[i][0];
+    }
+}
+
+
+// Compare the grids of two surfaces, the coordinates have to agree
+//  within a fraction _GridTolerance_ of the spacing
+static int SameGrid(const BatchSlot *a, const BatchSlot *b, int dimension){
+
+    int i;
+    size_t n_points;
+    double tolerance = _GridTolerance_ * fabs(b->dq);
+
+    for(i = 0, n_points = 1; i < dimension; ++i){
+        if(a->nq[i] != b->nq[i] || fabs(a->origin[i] - b->origin[i]) > tolerance){
+            return 0;
+        }
+        n_points *= b->nq[i];
+    }
+
+    return (n_points == a->n_points && n_points == b->n_points && fabs(a->dq - b->dq) <= tolerance);
+}
@@ -0,0 +1,514 @@
+#define _GNU_SOURCE
+#define _MaxStages_    32
+#define _MaxDimension_ 16
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "nx1dInterpolator.h"
+#include "nx1dIO.h"
+
+/* Benchmark and accuracy harness:
+//{{{
+    nx1d-bench interpolates a synthetic grid of an analytic function,
+    centred around the origin with spacing dq, and times every stage of
+    the interpolation pipeline:
+
+        parse       reading the grid from a temporary text file (InputFunction)
+        pass<p>     dimensional pass p of the plan (nx1dPlanPassTimes)
+        execute     all passes (nx1dPlanExecute or nx1dPlanExecuteFloat)
+        output      writing the interpolated grid to a temporary file
+
+    The execution is repeated <repeats> times and the fastest run (with its
+    passes) is reported, parse and output run once. The points of a stage
+    are the points it produces, its bytes the data it reads and writes (the
+    file size for parse and output). The interpolated grid is compared to
+    the analytic values, giving the rmsd (as testdata/rmsd.sh) and the
+    maximum deviation. Results are written as CSV (one row per stage) or
+    JSON.
+
+    Functions of r = |x|:
+        sinc        sin(r)/r
+        gauss       exp(-r^2/8)
+        poly        sum_k (x_k^3/20 - x_k^2/2 + x_k)
+//}}}*/
+enum { BENCH_SINC, BENCH_GAUSS, BENCH_POLY, BENCH_N_FUNCTIONS };
+static const char * function_names[BENCH_N_FUNCTIONS] = {"sinc", "gauss", "poly"};
+static const char * precision_names[] = {"double", "float", "mixed"};
+
+typedef struct BenchStage {
+    char   name[32];
+    double seconds;
+    double points;
+    double bytes;
+} BenchStage;
+
+// Internal prototypes
+static void   PrintUsage(char *name);
+static void   CheckError(int error);
+static double Now(void);
+static double Analytic(int function, const double *x, int dimension);
+static void   Generate(int function, double *v, const int *nq, const double *origin, double dq, int dimension);
+static double FileSize(const char *filename);
+static char * TempFile(void);
+
+
+static void PrintUsage(char *name){
+    fprintf(stderr,
+        "\nUsage: %s [-f function] [-n n_spline] [-d dq] [-t threads] [-r repeats] [-P precision] [-e]"
+        " [-w format] [-g] [-j] [-o reportfile] nq"
+        "\n"
+        "\n    nq         points per dimension, separated by x (e.g. 200x150x80)"
+        "\n    -f <name>  analytic function: sinc (default), gauss or poly"
+        "\n    -n <n>     number of interpolated points per interval (default: 1)"
+        "\n    -d <dq>    grid spacing (default: 0.5)"
+        "\n    -t <n>     number of threads (default: NX1D_NUM_THREADS or OMP_NUM_THREADS)"
+        "\n    -r <n>     number of timed executions, the fastest is reported (default: 3)"
+        "\n    -P <mode>  precision mode: double (default), float or mixed"
+        "\n    -e         use the recursive filter engine"
+        "\n    -w <fmt>   output stage format: text (default), binary or none"
+        "\n    -g         skip the parse stage"
+        "\n    -j         JSON report instead of CSV"
+        "\n    -o <file>  write the report to file instead of stdout"
+        "\n\n"
+        , name
+    );
+}
+
+int main(int argc, char **argv){
+
+    int i, k, p, r, opt;
+    int dimension = 0;
+    size_t j, n_points, nn_points, n_parsed;
+    int n_stages  = 0;
+    int n_spline  = 1;
+    int n_threads = 0;
+    int repeats   = 3;
+    int function  = BENCH_SINC;
+    int precision = NX1D_PRECISION_DOUBLE;
+    int engine    = NX1D_ENGINE_THOMAS;
+    int output    = 1;          // 0: none, 1: text, 2: binary
+    int parse     = 1;
+    int json      = 0;
+    double dq     = 0.5;
+    double seconds, best, bytes, elem_size;
+    double sum_sd, max_d, d, points_in, points_out;
+
+    int    nq[_MaxDimension_];
+    int    nq_new[_MaxDimension_];
+    int    nq_read[_MaxDimension_];
+    int    order[_MaxDimension_];
+    int    index[_MaxDimension_];
+    double origin[_MaxDimension_];
+    double x[_MaxDimension_];
+    double best_pass[_MaxDimension_];
+    BenchStage stage[_MaxStages_];
+
+    char   * next       = NULL;
+    char   * grid       = NULL;
+    char   * reportfile = NULL;
+    char   * tempfile   = NULL;
+    double * v  = NULL;
+    double * yy = NULL;
+    float  * vf = NULL;
+    float  * yf = NULL;
+    double ** q = NULL;
+    double  * v_read = NULL;
+    nx1dPlan * plan = NULL;
+    TextWriter * writer = NULL;
+    FILE * report = stdout;
+
+// Options
+    while((opt = getopt(argc, argv, "f:n:d:t:r:P:ew:gjo:")) != -1){
+        switch(opt){
+            case 'f':
+                for(function = 0; function < BENCH_N_FUNCTIONS; ++function){
+                    if(strcmp(optarg, function_names[function]) == 0) break;
+                }
+                if(function == BENCH_N_FUNCTIONS){
+                    fprintf(stderr, "\n(-) ERROR: unknown function \"%s\"\n    Aborting...\n\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'n':
+                n_spline = atoi(optarg);
+                break;
+            case 'd':
+                dq = atof(optarg);
+                break;
+            case 't':
+                n_threads = atoi(optarg);
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                break;
+            case 'P':
+                for(precision = 0; precision < 3; ++precision){
+                    if(strcmp(optarg, precision_names[precision]) == 0) break;
+                }
+                if(precision == 3){
+                    fprintf(stderr, "\n(-) ERROR: unknown precision \"%s\"\n    Aborting...\n\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'e':
+                engine = NX1D_ENGINE_FILTER;
+                break;
+            case 'w':
+                if(strcmp(optarg, "none") == 0){
+                    output = 0;
+                }else if(strcmp(optarg, "text") == 0){
+                    output = 1;
+                }else if(strcmp(optarg, "binary") == 0){
+                    output = 2;
+                }else{
+                    fprintf(stderr, "\n(-) ERROR: unknown output format \"%s\"\n    Aborting...\n\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'g':
+                parse = 0;
+                break;
+            case 'j':
+                json = 1;
+                break;
+            case 'o':
+                reportfile = optarg;
+                break;
+            default:
+                PrintUsage(argv[0]);
+                exit(1);
+        }
+    }
+    if(optind >= argc || repeats < 1 || dq <= 0.0){
+        PrintUsage(argv[0]);
+        exit(1);
+    }
+
+// Grid: nq[0]x...xnq[dimension-1], centred around the origin
+    grid = argv[optind];
+    for(next = grid; dimension < _MaxDimension_; ++next){
+        nq[dimension++] = (int)strtol(next, &next, 10);
+        if(*next != 'x') break;
+    }
+    if(*next != '\0'){
+        fprintf(stderr, "\n(-) ERROR: invalid grid \"%s\"\n    Aborting...\n\n", grid);
+        exit(1);
+    }
+    for(k = 0, n_points = 1; k < dimension; ++k){
+        origin[k] = -0.5 * (nq[k] - 1) * dq;
+        n_points *= nq[k];
+    }
+
+    v = malloc(n_points * sizeof(double));
+    if(v == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "input grid");
+        exit(2);
+    }
+    Generate(function, v, nq, origin, dq, dimension);
+
+// Parse stage: the grid is written to a text file and read back
+    if(parse){
+        tempfile = TempFile();
+        writer = TextOutputOpen(tempfile, nq, origin, dq, dimension, 1, 0);
+        TextOutputWrite(writer, v, n_points);
+        TextOutputClose(writer);
+
+        q = calloc(dimension, sizeof(double*));
+        if(q == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "coordinate arrays");
+            exit(2);
+        }
+        seconds = Now();
+        n_parsed = InputFunction(tempfile, &q, nq_read, &v_read, dimension, 1);
+        seconds = Now() - seconds;
+        if(n_parsed != n_points){
+            fprintf(stderr, "\n(-) ERROR: parsed %zu of %zu points\n    Aborting...\n\n", n_parsed, n_points);
+            exit(1);
+        }
+
+        strcpy(stage[n_stages].name, "parse");
+        stage[n_stages].seconds = seconds;
+        stage[n_stages].points  = n_points;
+        stage[n_stages].bytes   = FileSize(tempfile);
+        ++n_stages;
+
+        unlink(tempfile);
+        free(tempfile);
+        for(k = 0; k < dimension; ++k){
+            free(q[k]);
+        }
+        free(q);
+        free(v_read);
+    }
+
+// Plan
+    CheckError(nx1dPlanCreate(&plan, nq, dq, dimension, n_spline, 1));
+    if(n_threads > 0){
+        CheckError(nx1dPlanSetThreads(plan, n_threads));
+    }
+    CheckError(nx1dPlanSetEngine(plan, engine));
+    CheckError(nx1dPlanSetPrecision(plan, precision));
+    CheckError(nx1dPlanGetOrder(plan, order));
+    nn_points = nx1dPlanPoints(plan, nq_new);
+    elem_size = (precision == NX1D_PRECISION_DOUBLE) ? sizeof(double) : sizeof(float);
+
+    yy = malloc(nn_points * sizeof(double));
+    if(precision != NX1D_PRECISION_DOUBLE){
+        vf = malloc(n_points  * sizeof(float));
+        yf = malloc(nn_points * sizeof(float));
+    }
+    if(yy == NULL || (precision != NX1D_PRECISION_DOUBLE && (vf == NULL || yf == NULL))){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "interpolated grid");
+        exit(2);
+    }
+    for(j = 0; vf != NULL && j < n_points; ++j){
+        vf[j] = v[j];
+    }
+
+// Execute stage, fastest of <repeats> runs
+    for(r = 0, best = 0.0; r < repeats; ++r){
+        seconds = Now();
+        if(precision == NX1D_PRECISION_DOUBLE){
+            CheckError(nx1dPlanExecute(plan, v, yy));
+        }else{
+            CheckError(nx1dPlanExecuteFloat(plan, vf, yf));
+        }
+        seconds = Now() - seconds;
+        if(r == 0 || seconds < best){
+            best = seconds;
+            CheckError(nx1dPlanPassTimes(plan, best_pass));
+        }
+    }
+    for(j = 0; yf != NULL && j < nn_points; ++j){
+        yy[j] = yf[j];
+    }
+
+// the grid read and written by pass p has the dimensions order[0..p-1]
+//  (respectively order[0..p]) interpolated
+    for(k = 0; k < dimension; ++k){
+        index[k] = nq[k];
+    }
+    for(p = 0, bytes = 0.0; p < dimension; ++p){
+        for(k = 0, points_in = 1.0; k < dimension; ++k){
+            points_in *= index[k];
+        }
+        index[order[p]] = nq_new[order[p]];
+        points_out = points_in / nq[order[p]] * nq_new[order[p]];
+
+        snprintf(stage[n_stages].name, sizeof(stage[n_stages].name), "pass%d_dim%d", p, order[p]);
+        stage[n_stages].seconds = best_pass[p];
+        stage[n_stages].points  = points_out;
+        stage[n_stages].bytes   = (points_in + points_out) * elem_size;
+        bytes += stage[n_stages].bytes;
+        ++n_stages;
+    }
+    strcpy(stage[n_stages].name, "execute");
+    stage[n_stages].seconds = best;
+    stage[n_stages].points  = nn_points;
+    stage[n_stages].bytes   = bytes;
+    ++n_stages;
+
+// Accuracy: deviation from the analytic values on the interpolated grid
+    for(k = 0; k < dimension; ++k){
+        index[k] = 0;
+    }
+    for(j = 0, sum_sd = 0.0, max_d = 0.0; j < nn_points; ++j){
+        for(k = 0; k < dimension; ++k){
+            x[k] = origin[k] + index[k] * dq / (n_spline + 1);
+        }
+        d = yy[j] - Analytic(function, x, dimension);
+        sum_sd += d*d;
+        if(fabs(d) > max_d) max_d = fabs(d);
+
+        for(k = dimension-1; k >= 0; --k){
+            if(++index[k] < nq_new[k]) break;
+            index[k] = 0;
+        }
+    }
+
+// Output stage
+    if(output > 0){
+        tempfile = TempFile();
+        seconds = Now();
+        if(output == 2){
+            BinaryOutputFunction(tempfile, nq_new, origin, dq / (n_spline + 1), n_spline, yy, dimension, 1);
+        }else{
+            writer = TextOutputOpen(tempfile, nq_new, origin, dq / (n_spline + 1), dimension, 1, 0);
+            TextOutputWrite(writer, yy, nn_points);
+            TextOutputClose(writer);
+        }
+        seconds = Now() - seconds;
+
+        strcpy(stage[n_stages].name, (output == 2) ? "output_binary" : "output_text");
+        stage[n_stages].seconds = seconds;
+        stage[n_stages].points  = nn_points;
+        stage[n_stages].bytes   = FileSize(tempfile);
+        ++n_stages;
+
+        unlink(tempfile);
+        free(tempfile);
+    }
+
+// Report
+    if(reportfile != NULL && strcmp(reportfile, "-") != 0){
+        report = fopen(reportfile, "w");
+        if(report == NULL){
+            fprintf(stderr, "\n(-) ERROR opening report-file: \"%s\"\n    Exiting...\n\n", reportfile);
+            exit(1);
+        }
+    }
+    n_threads = nx1dPlanGetThreads(plan);
+
+    if(json){
+        fprintf(report, "{\n  \"function\": \"%s\",\n  \"dimension\": %d,\n  \"nq\": [", function_names[function], dimension);
+        for(k = 0; k < dimension; ++k){
+            fprintf(report, "%s%d", (k > 0) ? ", " : "", nq[k]);
+        }
+        fprintf(report, "],\n  \"dq\": %.17g,\n  \"n_spline\": %d,\n  \"precision\": \"%s\",\n"
+                        "  \"engine\": \"%s\",\n  \"threads\": %d,\n  \"repeats\": %d,\n"
+                        "  \"rmsd\": %.6e,\n  \"max_error\": %.6e,\n  \"stages\": [\n"
+                      , dq, n_spline, precision_names[precision]
+                      , (engine == NX1D_ENGINE_FILTER) ? "filter" : "thomas", n_threads, repeats
+                      , sqrt(sum_sd / nn_points), max_d);
+        for(i = 0; i < n_stages; ++i){
+            fprintf(report, "    {\"stage\": \"%s\", \"seconds\": %.6e, \"points\": %.0f, \"points_per_s\": %.6e,"
+                            " \"bytes\": %.0f, \"gb_per_s\": %.6e}%s\n"
+                          , stage[i].name, stage[i].seconds, stage[i].points, stage[i].points / stage[i].seconds
+                          , stage[i].bytes, stage[i].bytes / stage[i].seconds * 1.0e-9, (i < n_stages-1) ? "," : "");
+        }
+        fprintf(report, "  ]\n}\n");
+    }else{
+        fprintf(report, "function,nq,n_spline,precision,engine,threads,stage,seconds,points,points_per_s,"
+                        "bytes,gb_per_s,rmsd,max_error\n");
+        for(i = 0; i < n_stages; ++i){
+            fprintf(report, "%s,%s,%d,%s,%s,%d,%s,%.6e,%.0f,%.6e,%.0f,%.6e,%.6e,%.6e\n"
+                          , function_names[function], grid, n_spline, precision_names[precision]
+                          , (engine == NX1D_ENGINE_FILTER) ? "filter" : "thomas", n_threads
+                          , stage[i].name, stage[i].seconds, stage[i].points, stage[i].points / stage[i].seconds
+                          , stage[i].bytes, stage[i].bytes / stage[i].seconds * 1.0e-9
+                          , sqrt(sum_sd / nn_points), max_d);
+        }
+    }
+    if(report != stdout && fclose(report) != 0){
+        fprintf(stderr, "\n(-) ERROR writing report-file: \"%s\"\n    Exiting...\n\n", reportfile);
+        exit(1);
+    }
+
+    nx1dPlanDestroy(plan);
+    free(v);
+    free(vf);
+    free(yf);
+    free(yy);
+
+    return 0;
+}
+
+
+// Abort on an error code of the interpolation library
+static void CheckError(int error){
+
+    if(error == NX1D_SUCCESS) return;
+
+    fprintf(stderr, "\n(-) ERROR in interpolation:\n    %s\n    Aborting...\n\n", nx1dErrorString(error));
+    exit((error == NX1D_ERROR_MEMORY) ? 2 : 1);
+}
+
+
+// wall clock time in seconds
+static double Now(void){
+
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9 * t.tv_nsec;
+}
+
+
+// Value of the analytic function at the point x
+static double Analytic(int function, const double *x, int dimension){
+
+    int k;
+    double r = 0.0;
+
+    switch(function){
+        case BENCH_GAUSS:
+            for(k = 0; k < dimension; ++k){
+                r += x[k] * x[k];
+            }
+            return exp(-r / 8.0);
+        case BENCH_POLY:
+            for(k = 0; k < dimension; ++k){
+                r += x[k] * x[k] * x[k] / 20.0 - x[k] * x[k] / 2.0 + x[k];
+            }
+            return r;
+        default:
+            for(k = 0; k < dimension; ++k){
+                r += x[k] * x[k];
+            }
+            r = sqrt(r);
+            return (r < 1.0e-8) ? 1.0 - r * r / 6.0 : sin(r) / r;
+    }
+}
+
+
+// Tabulate the analytic function on the grid
+static void Generate(int function, double *v, const int *nq, const double *origin, double dq, int dimension){
+
+    int k;
+    int index[_MaxDimension_] = {0};
+    size_t i, n_points;
+    double x[_MaxDimension_];
+
+    for(k = 0, n_points = 1; k < dimension; ++k){
+        n_points *= nq[k];
+    }
+    for(i = 0; i < n_points; ++i){
+        for(k = 0; k < dimension; ++k){
+            x[k] = origin[k] + index[k] * dq;
+        }
+        v[i] = Analytic(function, x, dimension);
+
+        for(k = dimension-1; k >= 0; --k){
+            if(++index[k] < nq[k]) break;
+            index[k] = 0;
+        }
+    }
+}
+
+
+// Size of a file in bytes
+static double FileSize(const char *filename){
+
+    struct stat st;
+
+    return (stat(filename, &st) == 0) ? (double)st.st_size : 0.0;
+}
+
+
+// Create an empty temporary file in TMPDIR (or /tmp), returns its malloc'ed name
+static char * TempFile(void){
+
+    int fd;
+    char * dir  = getenv("TMPDIR");
+    char * name = NULL;
+
+    if(dir == NULL || dir[0] == '\0') dir = "/tmp";
+    if(asprintf(&name, "%s/nx1d-bench-XXXXXX", dir) < 0){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "file name");
+        exit(2);
+    }
+    fd = mkstemp(name);
+    if(fd < 0){
+        fprintf(stderr, "\n(-) ERROR creating temporary file in \"%s\"\n    Exiting...\n\n", dir);
+        exit(1);
+    }
+    close(fd);
+
+    return name;
+}
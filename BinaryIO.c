@@ -0,0 +1,443 @@
+#define _GNU_SOURCE
+#define _BinaryMagic_   "NX1DGRID"
+#define _BinaryVersion_ 1
+#define _BinaryChunk_   (1 << 16)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "nx1dIO.h"
+
+/* Binary grid format:
+//{{{
+    All entries are stored little-endian, the header is a multiple of 8 bytes
+    long so that the payload is correctly aligned for double access when the
+    file is mapped into memory.
+
+        offset          type        content
+        -----------------------------------------------------------------
+        0               char[8]     magic "NX1DGRID"
+        8               uint32      format version (1)
+        12              uint32      dimension
+        16              uint32      n_spline the grid was interpolated with
+        20              uint32      number of values n_values per grid point
+        24              double      grid spacing dq
+        32              int64[d]    number of points per dimension nq[]
+        32 +  8 d       double[d]   origin, i.e. coordinates of the first point
+        32 + 16 d       double[]    values, last dimension running fastest,
+                                    the n_values values of a point next to
+                                    each other
+
+    On little-endian hosts the payload is used in place (zero-copy), i.e.
+    the returned value array points directly into the mapped file. The
+    header is not trusted: every nq[] has to be in [2, INT_MAX] and the
+    payload it describes has to fit into the address space and the file.
+//}}}*/
+
+// Internal prototypes
+static int      HostIsLittleEndian(void);
+static uint64_t SwapBytes64(uint64_t x);
+static uint32_t ReadU32(const unsigned char *p);
+static uint64_t ReadU64(const unsigned char *p);
+static void     PutU32(unsigned char *p, uint32_t x);
+static void     PutU64(unsigned char *p, uint64_t x);
+static int      WriteAll(int fd, const void *buffer, size_t size, off_t offset);
+
+
+// Binary files are recognized by their extension ".nx1d"
+int IsBinaryFile(const char *filename){
+
+    size_t length;
+
+    if(filename == NULL) return 0;
+    length = strlen(filename);
+
+    return (length > 5 && strcmp(filename + length - 5, ".nx1d") == 0);
+}
+
+
+// Map a binary grid, the number of values per point is stored to
+//  *n_values, returns the number of points
+size_t BinaryInputFunction(char *inputfile, BinaryMap *map, int *nq, double *origin, double *dq,
+                           int *n_spline, int *n_values, double **V, int dimension){
+
+    int fd;
+    size_t i, n_points, n_entries;
+    uint64_t aux;
+    size_t header_size;
+    const unsigned char * data = NULL;
+    struct stat sb;
+
+    map->base   = NULL;
+    map->size   = 0;
+    map->mapped = 0;
+
+    fd = open(inputfile, O_RDONLY);
+    if(fd < 0 || fstat(fd, &sb) != 0){
+        fprintf(stderr,
+            "\n(-) ERROR opening input-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , inputfile
+        );
+        exit(1);
+    }
+
+    header_size = BinaryHeaderSize(dimension);
+    if((size_t)sb.st_size < header_size){
+        fprintf(stderr,
+            "\n(-) ERROR reading data from input-file \"%s\"."
+            "\n    The file is too short for a %d dimensional binary grid."
+            "\n    Aborting - please check your input..."
+            "\n\n"
+            , inputfile, dimension
+        );
+        exit(1);
+    }
+
+    map->base = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map->base == MAP_FAILED){
+        fprintf(stderr,
+            "\n(-) ERROR mapping input-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , inputfile
+        );
+        exit(1);
+    }
+    map->size   = sb.st_size;
+    map->mapped = 1;
+    data = map->base;
+
+// check header
+    if(memcmp(data, _BinaryMagic_, 8) != 0 || ReadU32(data + 8) != _BinaryVersion_){
+        fprintf(stderr,
+            "\n(-) ERROR reading data from input-file \"%s\"."
+            "\n    The file is no version %d binary grid file."
+            "\n    Aborting - please check your input..."
+            "\n\n"
+            , inputfile, _BinaryVersion_
+        );
+        exit(1);
+    }
+    if((int)ReadU32(data + 12) != dimension || ReadU32(data + 20) < 1 || ReadU32(data + 20) > INT_MAX
+    || ReadU32(data + 16) > INT_MAX){
+        fprintf(stderr,
+            "\n(-) ERROR reading data from input-file \"%s\"."
+            "\n    The file contains a %d dimensional grid with %d values per point,"
+            "\n    expected is a %d dimensional grid."
+            "\n    Aborting - please check your input..."
+            "\n\n"
+            , inputfile, (int)ReadU32(data + 12), (int)ReadU32(data + 20), dimension
+        );
+        exit(1);
+    }
+
+    (*n_spline) = ReadU32(data + 16);
+    (*n_values) = ReadU32(data + 20);
+    aux = ReadU64(data + 24);
+    memcpy(dq, &aux, sizeof(double));
+
+// the points per dimension have to fit an int and the whole payload the
+//  address space and the file (checked without overflowing size_t)
+    for(i = 0, n_points = 1; i < (size_t)dimension; ++i){
+        aux = ReadU64(data + 32 + 8*i);
+        if(aux < 2 || aux > INT_MAX || n_points > SIZE_MAX / sizeof(double) / (*n_values) / aux){
+            fprintf(stderr,
+                "\n(-) ERROR reading data from input-file \"%s\"."
+                "\n    The header describes an invalid grid (%llu points in dimension %zu)."
+                "\n    Aborting - please check your input..."
+                "\n\n"
+                , inputfile, (unsigned long long)aux, i
+            );
+            exit(1);
+        }
+        nq[i] = (int)aux;
+        aux   = ReadU64(data + 32 + 8*(dimension + i));
+        memcpy(&origin[i], &aux, sizeof(double));
+        n_points *= nq[i];
+    }
+    n_entries = n_points * (*n_values);
+
+    if(n_entries > ((size_t)sb.st_size - header_size) / sizeof(double)){
+        fprintf(stderr,
+            "\n(-) ERROR reading data from input-file \"%s\"."
+            "\n    The file is too short for %zu points."
+            "\n    Aborting - please check your input..."
+            "\n\n"
+            , inputfile, n_points
+        );
+        exit(1);
+    }
+
+// zero-copy access on little-endian hosts, otherwise a byte swapped copy
+    if(HostIsLittleEndian()){
+        madvise(map->base, map->size, MADV_SEQUENTIAL);
+        (*V) = (double*)(data + header_size);
+    }else{
+        (*V) = malloc(n_entries * sizeof(double));
+        if((*V) == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "potential");
+            exit(2);
+        }
+        for(i = 0; i < n_entries; ++i){
+            aux = ReadU64(data + header_size + 8*i);
+            memcpy(&(*V)[i], &aux, sizeof(double));
+        }
+        munmap(map->base, map->size);
+        map->base   = (*V);
+        map->size   = n_entries * sizeof(double);
+        map->mapped = 0;
+    }
+
+    return n_points;
+}
+
+
+// Map the values of the n_entries doubles of a binary grid file shared and
+//  writable, so they can be changed in place (on little-endian hosts only).
+//  Returns NULL if the file can't be mapped, the mapping is released by
+//  BinaryInputRelease.
+double * BinaryMapWritable(char *file, BinaryMap *map, size_t n_entries, int dimension){
+
+    int fd;
+    size_t size;
+    struct stat sb;
+
+    map->base   = NULL;
+    map->size   = 0;
+    map->mapped = 0;
+    if(!HostIsLittleEndian()) return NULL;
+    if(n_entries > (SIZE_MAX - BinaryHeaderSize(dimension)) / sizeof(double)) return NULL;
+    size = BinaryHeaderSize(dimension) + n_entries * sizeof(double);
+
+    fd = open(file, O_RDWR);
+    if(fd < 0) return NULL;
+    if(fstat(fd, &sb) != 0 || (size_t)sb.st_size < size){
+        close(fd);
+        return NULL;
+    }
+    map->base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map->base == MAP_FAILED){
+        map->base = NULL;
+        return NULL;
+    }
+    map->size   = size;
+    map->mapped = 1;
+
+    return (double*)((char*)map->base + BinaryHeaderSize(dimension));
+}
+
+
+// Release the value array returned by BinaryInputFunction
+void BinaryInputRelease(BinaryMap *map){
+
+    if(map->base == NULL) return;
+
+    if(map->mapped){
+        munmap(map->base, map->size);
+    }else{
+        free(map->base);
+    }
+    map->base = NULL;
+    map->size = 0;
+}
+
+
+// Size of the header of a dimension-dimensional grid in bytes
+size_t BinaryHeaderSize(int dimension){
+    return 32 + 16 * (size_t)dimension;
+}
+
+
+// Open outputfile (stdout if NULL or "-") and write the header
+//  of a grid, returns the file descriptor
+int BinaryOutputOpen(char *outputfile, const int *nq, const double *origin, double dq,
+                     int n_spline, int dimension, int n_values){
+
+    int i, fd;
+    uint64_t aux;
+    size_t header_size = BinaryHeaderSize(dimension);
+    unsigned char * header = NULL;
+
+    if(outputfile == NULL || strcmp(outputfile, "-") == 0){
+        fd = STDOUT_FILENO;
+    }else{
+        fd = open(outputfile, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    }
+    if(fd < 0){
+        fprintf(stderr,
+            "\n(-) ERROR opening output-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , outputfile
+        );
+        exit(1);
+    }
+
+// assemble header
+    header = calloc(header_size, 1);
+    if(header == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "binary header");
+        exit(2);
+    }
+    memcpy(header, _BinaryMagic_, 8);
+    PutU32(header +  8, _BinaryVersion_);
+    PutU32(header + 12, dimension);
+    PutU32(header + 16, n_spline);
+    PutU32(header + 20, n_values);
+    memcpy(&aux, &dq, sizeof(double));
+    PutU64(header + 24, aux);
+    for(i = 0; i < dimension; ++i){
+        PutU64(header + 32 + 8*i, nq[i]);
+        memcpy(&aux, &origin[i], sizeof(double));
+        PutU64(header + 32 + 8*(dimension + i), aux);
+    }
+    if(WriteAll(fd, header, header_size, -1) != 0){
+        fprintf(stderr,
+            "\n(-) ERROR writing output-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , (outputfile == NULL) ? "-" : outputfile
+        );
+        exit(1);
+    }
+    free(header);
+
+    return fd;
+}
+
+
+// Write n values of V to fd, at the byte position offset or, if offset
+//  is negative, at the current file position. Values are written directly
+//  from V or byte swapped in chunks. Returns 0 on success.
+int BinaryOutputBlock(int fd, const double *V, size_t n, off_t offset){
+
+    size_t i, j, n_chunk;
+    int failed = 0;
+    uint64_t aux;
+    uint64_t * chunk = NULL;
+
+    if(HostIsLittleEndian()){
+        return WriteAll(fd, V, n * sizeof(double), offset);
+    }
+
+    chunk = malloc(_BinaryChunk_ * sizeof(uint64_t));
+    if(chunk == NULL) return 1;
+
+    for(i = 0; i < n && !failed; i += n_chunk){
+        n_chunk = (n - i < _BinaryChunk_) ? n - i : _BinaryChunk_;
+        for(j = 0; j < n_chunk; ++j){
+            memcpy(&aux, &V[i+j], sizeof(double));
+            chunk[j] = SwapBytes64(aux);
+        }
+        failed = WriteAll(fd, chunk, n_chunk * sizeof(uint64_t), offset);
+        if(offset >= 0) offset += n_chunk * sizeof(uint64_t);
+    }
+    free(chunk);
+
+    return failed;
+}
+
+
+// Close a binary output file, exits if any write failed
+void BinaryOutputClose(int fd, char *outputfile, int failed){
+
+    if(fd != STDOUT_FILENO && close(fd) != 0){
+        failed = 1;
+    }
+    if(failed){
+        fprintf(stderr,
+            "\n(-) ERROR writing output-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , (outputfile == NULL) ? "-" : outputfile
+        );
+        exit(1);
+    }
+}
+
+
+// Write a grid of n_values values per point to outputfile (stdout if NULL
+//  or "-"), the values are written directly from V. Returns the number of
+//  written points.
+size_t BinaryOutputFunction(char *outputfile, const int *nq, const double *origin, double dq,
+                            int n_spline, const double *V, int dimension, int n_values){
+
+    int i, fd;
+    size_t n_points;
+
+    for(i = 0, n_points = 1; i < dimension; ++i){
+        if(nq[i] < 1 || n_values < 1 || n_points > SIZE_MAX / sizeof(double) / n_values / nq[i]){
+            fprintf(stderr,
+                "\n(-) ERROR writing output-file: \"%s\""
+                "\n    The grid (%d points in dimension %d) exceeds the address space."
+                "\n    Exiting..."
+                "\n\n"
+                , (outputfile == NULL) ? "-" : outputfile, nq[i], i
+            );
+            exit(1);
+        }
+        n_points *= nq[i];
+    }
+
+    fd = BinaryOutputOpen(outputfile, nq, origin, dq, n_spline, dimension, n_values);
+    BinaryOutputClose(fd, outputfile, BinaryOutputBlock(fd, V, n_points * n_values, -1));
+
+    return n_points;
+}
+
+
+static int HostIsLittleEndian(void){
+
+    const uint16_t one = 1;
+
+    return *(const unsigned char*)&one == 1;
+}
+
+static uint64_t SwapBytes64(uint64_t x){
+    return __builtin_bswap64(x);
+}
+
+static uint32_t ReadU32(const unsigned char *p){
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t ReadU64(const unsigned char *p){
+    return (uint64_t)ReadU32(p) | (uint64_t)ReadU32(p + 4) << 32;
+}
+
+static void PutU32(unsigned char *p, uint32_t x){
+    p[0] = x; p[1] = x >> 8; p[2] = x >> 16; p[3] = x >> 24;
+}
+
+static void PutU64(unsigned char *p, uint64_t x){
+    PutU32(p, (uint32_t)x);
+    PutU32(p + 4, (uint32_t)(x >> 32));
+}
+
+// write size bytes at offset (or the current position if offset is
+//  negative), retrying on partial writes; returns 0 on success
+static int WriteAll(int fd, const void *buffer, size_t size, off_t offset){
+
+    ssize_t n;
+    const char * p = buffer;
+
+    while(size > 0){
+        n = (offset < 0) ? write(fd, p, size) : pwrite(fd, p, size, offset);
+        if(n <= 0) return 1;
+        p    += n;
+        size -= n;
+        if(offset >= 0) offset += n;
+    }
+    return 0;
+}
@@ -1,28 +1,59 @@
-
 #define _GNU_SOURCE
-#define _MaxLineLength_ 2048
+#define _ReadBlockSize_ (1 << 24)
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // Offered prototypes
-int InputFunction(char *inputfile, double ***q, int *nq, double **V, int dimension);
+size_t InputFunction(char *inputfile, double ***q, int *nq, double **V, int dimension, int n_values);
+int PointInputFunction(char *inputfile, double **x, int dimension);
 
-int InputFunction(char *inputfile, double ***q, int *nq, double **V, int dimension){
+// Internal prototypes
+static char * MapInputFile(char *inputfile, size_t *size, int *mapped);
+static double ParseDouble(const char *p, const char *end, const char **endptr);
+static int    GrowArrays(double ***q, double **V, int dimension, int n_values, size_t capacity);
 
-    int rows, comment_flag;
-    int n;
-    unsigned int i;
-    char * comment = "#%\n";
-    char * line    = NULL;
-    char * token = NULL;
-    char   buffer[_MaxLineLength_] = "";
-    FILE * fd;
-
-    fd = fopen(inputfile, "r");
-    if(fd == NULL){
+/* Input parsing:
+//{{{
+    The whole file is mapped into memory (or, if it can't be mapped, read in
+    large blocks) and parsed in a single pass without copying or tokenizing
+    lines. Since the N line tells the number of grid points, the coordinate
+    arrays and V are allocated exactly once as soon as it is read. Files
+    without (or with a too small) N line are still supported, the arrays
+    then grow geometrically.
+
+    Input format:
+        - everything behind a comment character (# or %) is ignored
+        - a line whose first non-white-space character is n or N contains
+          the number of points of each of the <dimension> dimensions
+        - every other non-empty line contains <dimension> coordinates and
+          the <n_values> values of the point (e.g. the potentials of several
+          surfaces), separated by blanks or tabulators
+
+    The values of a point are stored next to each other, V[row*n_values + s].
+//}}}*/
+size_t InputFunction(char *inputfile, double ***q, int *nq, double **V, int dimension, int n_values){
+
+    size_t rows, capacity;
+    int n, mapped;
+    size_t size;
+    double value;
+    char * comment = "#%";
+    char * data = NULL;
+    const char * p    = NULL;
+    const char * eol  = NULL;
+    const char * end  = NULL;
+    const char * next = NULL;
+
+    data = MapInputFile(inputfile, &size, &mapped);
+    if(data == NULL){
         fprintf(stderr,
             "\n(-) ERROR opening input-file: \"%s\""
             "\n    Exiting..."
@@ -32,44 +63,37 @@ int InputFunction(char *inputfile, double ***q, int *nq, double **V, int dimensi
         exit(1);
     }
 
-    rows = 0;
-    while(fgets(buffer, sizeof(buffer), fd) != NULL){
+    rows     = 0;
+    capacity = 0;
+    for(p = data, end = data + size; p < end; p = eol + 1){
 
-    // check if the first character in buffer is a comment char,
-    //  if yes jump to next line
-        comment_flag = 0;
-        for(i=0; i<strlen(comment); ++i){
-            if(buffer[0] == comment[i]){
-                comment_flag = 1;
+    // determine end of line and strip comments
+        eol = memchr(p, '\n', end - p);
+        if(eol == NULL) eol = end;
+        for(next = p; next < eol; ++next){
+            if(next[0] == comment[0] || next[0] == comment[1]){
                 break;
             }
         }
-        if(comment_flag == 1) continue;
-
-    // copy "buffer" with stripped comments to new buffer "line"
-        line = strtok(buffer, comment);
-        if(line == NULL) continue;
 
     // remove leading white spaces and tabulators
     //  and skip empty lines
-        while(isspace(*line)) line++;
-        if(strlen(line) == 0) continue;
+        while(p < next && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')) p++;
+        if(p == next) continue;
 
-    // At this point the requested input line is stripped of
+    // At this point the requested input line [p,next) is stripped of
     //  comments and blank lines. From here on the parsing starts:
-    //    printf("%s\n", line);
 //-----------------------------------------------------------------------------------
 
     // If the first non-white-space char of a line is either n or N get number of coordinate entries
-        if(strcasestr(line, "N") != NULL){
-        // Tokenize line, get first entry which ain't a white space
-            token = strtok(line, " \t");
+        if(*p == 'n' || *p == 'N'){
+            ++p;
 
         // read the first <dimension> entries after the N flag
             for(n = 0; n < dimension; ++n){
-                token = strtok(NULL, " \t");
+                value = ParseDouble(p, next, &p);
             // if there are less than <dimension> entries print an error
-                if(token == NULL){
+                if(p == NULL){
                     fprintf(stderr,
                         "\n(-) ERROR reading data from input-file \"%s\"."
                         "\n    The N line doesn't contain %d entries."
@@ -79,81 +103,357 @@ int InputFunction(char *inputfile, double ***q, int *nq, double **V, int dimensi
                     );
                     exit(1);
                 }
-                nq[n] = atoi(token);
+            // the entries have to fit an int (the negated check catches nan)
+                if(!(value >= 0.0 && value <= INT_MAX)){
+                    fprintf(stderr,
+                        "\n(-) ERROR reading data from input-file \"%s\"."
+                        "\n    The N line contains an invalid number of points (%g)."
+                        "\n    Aborting - please check your input..."
+                        "\n\n"
+                        , inputfile, value
+                    );
+                    exit(1);
+                }
+                nq[n] = (int)value;
             }
-            continue;
-        }
-
-
-    // Start reading data:
-    //  Break down string array "line" to <dimension + 3> string tokens "token"
 
-    // Get first token, convert it to double and store it in q[0]
-        token = strtok(line, " \t");
-        if(token != NULL){
-        // reallocate memory for q array
-            for(n = 0; n < dimension; ++n){
-                (*q)[n] = realloc((*q)[n], (rows + 1)*sizeof(double));
-                if( (*q)[n] == NULL){
+        // allocate memory for all points at once, the arrays of the N line
+        //  have to fit into the address space
+            for(n = 0, capacity = 1; n < dimension; ++n){
+                if(nq[n] > 0 && capacity > SIZE_MAX / sizeof(double) / n_values / nq[n]){
                     fprintf(stderr,
-                        "\n(-) ERROR in reallocation of %s"
-                        "\n    Aborting...\n\n"
+                        "\n(-) ERROR reading data from input-file \"%s\"."
+                        "\n    The grid of the N line exceeds the address space."
+                        "\n    Aborting - please check your input..."
                         "\n\n"
-                        , "coordinate"
+                        , inputfile
                     );
-                    exit(2);
+                    exit(1);
                 }
+                capacity *= (nq[n] > 0) ? nq[n] : 1;
             }
-            (*q)[0][rows] = atof(token);
+            if(capacity < rows) capacity = rows;
+            if(GrowArrays(q, V, dimension, n_values, capacity) != 0){
+                fprintf(stderr,
+                    "\n(-) ERROR in allocation of %s"
+                    "\n    Aborting..."
+                    "\n\n"
+                    , "coordinate and potential arrays"
+                );
+                exit(2);
+            }
+            continue;
         }
 
-    // store the other <dimension - 1> coordinate entries
-        for(n = 1; n < dimension; ++n){
-            token = strtok(NULL, " \t");
-            if(token == NULL){
+    // Start reading data:
+    //  without (sufficient) N line the arrays grow geometrically, a capacity
+    //  that can't be doubled is passed as SIZE_MAX, which GrowArrays refuses
+        if(rows == capacity){
+            capacity = (capacity == 0) ? 1024 : (capacity <= SIZE_MAX / 2) ? 2 * capacity : SIZE_MAX;
+            if(GrowArrays(q, V, dimension, n_values, capacity) != 0){
+                fprintf(stderr,
+                    "\n(-) ERROR in reallocation of %s"
+                    "\n    Aborting..."
+                    "\n\n"
+                    , "coordinate and potential arrays"
+                );
+                exit(2);
+            }
+        }
+
+    // store the <dimension> coordinate entries followed by the n_values values
+        for(n = 0; n < dimension + n_values; ++n){
+            if(n < dimension){
+                (*q)[n][rows] = ParseDouble(p, next, &p);
+            }else{
+                (*V)[rows * n_values + n - dimension] = ParseDouble(p, next, &p);
+            }
+            if(p == NULL){
                 fprintf(stderr,
                     "\n(-) ERROR reading data from input-file \"%s\"."
-                    "\n    Too few entries in input line number %d"
+                    "\n    Too few entries in input line number %zu"
                     "\n    Aborting - please check your input..."
                     "\n\n"
                     , inputfile, rows
                 );
                 exit(1);
             }
-            (*q)[n][rows] = atof(token);
         }
 
-    // store potential values:
-    //  increase array size:
-        (*V) = realloc((*V), (rows + 1)*sizeof(double));
-        if( (*V) == NULL){
-            fprintf(stderr,
-                "\n(-) ERROR in reallocation of %s"
-                "\n    Aborting..."
-                "\n\n"
-                , "potential"
-            );
-            exit(2);
-        }
-    // get token and convert to double
-        token = strtok(NULL, " \t");
-        if(token == NULL){
-            fprintf(stderr,
-                "\n(-) ERROR reading data from input-file \"%s\"."
-                "\n    Too few entries in input line number %d"
-                "\n    Aborting - please check your input..."
-                "\n\n"
-                , inputfile, rows
-            );
-            exit(1);
+    // increment number of rows by 1
+        ++rows;
+
+    }
+
+    if(mapped){
+        munmap(data, size);
+    }else{
+        free(data);
+    }
+    data = NULL;
+
+    return rows;
+}
+
+
+// Read the points of a scattered point evaluation: every non-empty line
+//  holds <dimension> coordinates, further columns are ignored (so the text
+//  output of a grid can be used as well) and N lines (n or N followed by a
+//  blank, a number or the end of the line) are skipped, so coordinates such
+//  as nan are still read. The coordinates are stored point by point to *x,
+//  returns the number of points.
+int PointInputFunction(char *inputfile, double **x, int dimension){
+
+    int rows, capacity, n, mapped, line;
+    size_t size;
+    char * data = NULL;
+    double * aux = NULL;
+    const char * p    = NULL;
+    const char * eol  = NULL;
+    const char * end  = NULL;
+    const char * next = NULL;
+
+    data = MapInputFile(inputfile, &size, &mapped);
+    if(data == NULL){
+        fprintf(stderr,
+            "\n(-) ERROR opening point-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , inputfile
+        );
+        exit(1);
+    }
+
+    rows     = 0;
+    capacity = 0;
+    line     = 0;
+    for(p = data, end = data + size; p < end; p = eol + 1){
+
+        ++line;
+
+    // determine end of line, strip comments and leading blanks
+        eol = memchr(p, '\n', end - p);
+        if(eol == NULL) eol = end;
+        for(next = p; next < eol && *next != '#' && *next != '%'; ++next);
+        while(p < next && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')) p++;
+        if(p == next) continue;
+        if((*p == 'n' || *p == 'N')
+        && (p + 1 == next || p[1] == ' ' || p[1] == '\t' || p[1] == '\r' || (p[1] >= '0' && p[1] <= '9'))) continue;
+
+        if(rows == capacity){
+            capacity = (capacity > 0) ? 2 * capacity : 1024;
+            aux = realloc((*x), (size_t)capacity * dimension * sizeof(double));
+            if(aux == NULL){
+                fprintf(stderr, "\n(-) ERROR in reallocation of %s\n    Aborting...\n\n", "point array");
+                exit(2);
+            }
+            (*x) = aux;
         }
-        (*V)[rows] = atof(token);
 
-    // increment number of rows by 1
+        for(n = 0; n < dimension; ++n){
+            (*x)[(size_t)rows * dimension + n] = ParseDouble(p, next, &p);
+            if(p == NULL){
+                fprintf(stderr,
+                    "\n(-) ERROR reading data from point-file \"%s\"."
+                    "\n    Too few or malformed entries in line number %d"
+                    "\n    Aborting - please check your input..."
+                    "\n\n"
+                    , inputfile, line
+                );
+                exit(1);
+            }
+        }
         ++rows;
+    }
 
+    if(mapped){
+        munmap(data, size);
+    }else{
+        free(data);
     }
-    fclose(fd); fd = NULL;
 
     return rows;
 }
+
+
+// Map the input file into memory, if that is impossible (e.g. for pipes)
+//  read it in blocks of _ReadBlockSize_ bytes. Returns NULL on failure.
+static char * MapInputFile(char *inputfile, size_t *size, int *mapped){
+
+    int fd;
+    ssize_t nread;
+    size_t capacity;
+    char * data = NULL;
+    char * aux  = NULL;
+    struct stat sb;
+
+    (*size)   = 0;
+    (*mapped) = 0;
+
+    if(inputfile == NULL) return NULL;
+    fd = open(inputfile, O_RDONLY);
+    if(fd < 0) return NULL;
+
+// regular files are mapped read only, an empty file is
+//  represented by a one byte dummy buffer
+    if(fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode)){
+        if(sb.st_size == 0){
+            close(fd);
+            return calloc(1, 1);
+        }
+        data = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data != MAP_FAILED){
+            madvise(data, sb.st_size, MADV_SEQUENTIAL);
+            close(fd);
+            (*size)   = sb.st_size;
+            (*mapped) = 1;
+            return data;
+        }
+        data = NULL;
+    }
+
+// fall back to block wise reading
+    capacity = 0;
+    do{
+        if((*size) + _ReadBlockSize_ > capacity){
+            capacity = 2 * capacity + _ReadBlockSize_;
+            aux = realloc(data, capacity);
+            if(aux == NULL){
+                free(data);
+                close(fd);
+                return NULL;
+            }
+            data = aux;
+        }
+        nread = read(fd, data + (*size), _ReadBlockSize_);
+        if(nread > 0) (*size) += nread;
+    }while(nread > 0);
+
+    close(fd);
+    if(nread < 0){
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+// Resize coordinate arrays and potential array to <capacity> points, returns 1
+//  if the arrays exceed the address space or the allocation fails
+// Resize coordinate arrays and potential array to <capacity> points
+static int GrowArrays(double ***q, double **V, int dimension, int n_values, size_t capacity){
+
+    int n;
+    double * aux = NULL;
+
+    if(capacity > SIZE_MAX / sizeof(double) / n_values) return 1;
+
+    for(n = 0; n < dimension; ++n){
+        aux = realloc((*q)[n], capacity * sizeof(double));
+        if(aux == NULL) return 1;
+        (*q)[n] = aux;
+    }
+    aux = realloc((*V), capacity * n_values * sizeof(double));
+    if(aux == NULL) return 1;
+    (*V) = aux;
+
+    return 0;
+}
+
+
+/* Locale independent conversion of a decimal number:
+//{{{
+    Skips leading blanks and converts the following number in [p,end). On
+    success *endptr points behind the number, if there is no number left
+    *endptr is set to NULL.
+
+    Numbers with at most 15 significant digits and a decimal exponent of
+    at most 22 in magnitude are converted exactly (Clinger's fast path):
+    both the mantissa and the power of ten are exactly representable
+    doubles and a single multiplication or division is correctly rounded.
+    This covers practically all input files, everything else (long
+    mantissas, large exponents, nan, inf) is handed over to strtod which
+    yields the identical, correctly rounded result.
+//}}}*/
+static double ParseDouble(const char *p, const char *end, const char **endptr){
+
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    int negative = 0;
+    int digits   = 0;
+    int exponent = 0;
+    int exp_sign = 1;
+    int exp_val  = 0;
+    uint64_t mantissa = 0;
+    const char * start = NULL;
+    char buffer[128];
+    double value;
+
+// skip blanks
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')) p++;
+    if(p == end){
+        (*endptr) = NULL;
+        return 0.0;
+    }
+    start = p;
+
+// sign, integer part and fraction
+    if(*p == '-' || *p == '+'){
+        negative = (*p == '-');
+        ++p;
+    }
+    while(p < end && *p == '0') ++p;
+    for(; p < end && *p >= '0' && *p <= '9'; ++p, ++digits){
+        if(digits < 19) mantissa = 10 * mantissa + (*p - '0');
+        else            ++exponent;
+    }
+    if(p < end && *p == '.'){
+        ++p;
+        if(digits == 0){
+            for(; p < end && *p == '0'; ++p) --exponent;
+        }
+        for(; p < end && *p >= '0' && *p <= '9'; ++p, ++digits){
+            if(digits < 19){
+                mantissa = 10 * mantissa + (*p - '0');
+                --exponent;
+            }
+        }
+    }
+
+// exponent
+    if(p < end && (*p == 'e' || *p == 'E')){
+        ++p;
+        if(p < end && (*p == '-' || *p == '+')){
+            exp_sign = (*p == '-') ? -1 : 1;
+            ++p;
+        }
+        for(; p < end && *p >= '0' && *p <= '9'; ++p){
+            if(exp_val < 100000) exp_val = 10 * exp_val + (*p - '0');
+        }
+        exponent += exp_sign * exp_val;
+    }
+
+// fast path, the token has to end with a blank or the end of the line
+    if((p == end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')
+    && p > start && digits <= 15 && exponent >= -22 && exponent <= 22){
+        value = (double)mantissa;
+        value = (exponent < 0) ? value / pow10[-exponent] : value * pow10[exponent];
+        (*endptr) = p;
+        return negative ? -value : value;
+    }
+
+// slow path: copy the token and convert it by strtod
+    for(p = start; p < end && !(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f'); ++p);
+    if((size_t)(p - start) >= sizeof(buffer)){
+        (*endptr) = NULL;
+        return 0.0;
+    }
+    memcpy(buffer, start, p - start);
+    buffer[p - start] = '\0';
+    value = strtod(buffer, NULL);
+
+    (*endptr) = p;
+    return value;
+}
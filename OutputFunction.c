@@ -0,0 +1,369 @@
+#define _GNU_SOURCE
+#define _OutputBufferSize_ (1 << 22)
+#define _MaxEntryLength_   352
+#define _CoordSlotLength_  32
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "nx1dIO.h"
+
+/* Buffered text output:
+//{{{
+    The text output consists of the N line followed by one line per point
+
+        \t% 16.12lf (coordinates)   \t% 16.12lf (n_values values)   \n
+
+    where a block of points is preceded by one blank line per dimension whose
+    index (and the indices of all subordinate dimensions) start over, i.e.
+    by as many blank lines as the multi-index of the point has trailing zeros.
+
+    Instead of dimension+1 printf calls and a loop of modulus operations per
+    point, the multi-index is incremented like an odometer and the numbers
+    are formatted by FormatFixed12 into a large buffer which is handed to
+    write() whenever it is full. The formatted output is byte-identical to
+    the "% 16.12lf" conversion of printf.
+
+    The coordinates are never stored per point: the j-th coordinate of a
+    point is origin[j] + index[j]*dq. Since index[j] only takes nq[j] values,
+    the formatted coordinates are prepared once per dimension on opening the
+    writer and copied to the buffer afterwards. With TEXT_NO_COORDINATES only the
+    values are written.
+//}}}*/
+struct TextWriter {
+    int      fd;
+    int      dimension;
+    int      n_values;      // number of value columns
+    int    * nq;            // number of points per dimension
+    int    * index;         // multi-index of the next point
+    int      coordinates;   // 1 if coordinate columns are written
+    double * origin;        // coordinates of the first point
+    double   dq;            // grid spacing
+    char  ** coord_text;    // formatted coordinates, nq[j] slots per dimension
+    unsigned char ** coord_length; // length of each formatted coordinate
+    int      failed;        // set if a write failed
+    size_t   used;          // number of used bytes of buffer
+    char   * buffer;
+};
+
+// Internal prototypes
+static int  FormatFixed12(char *dst, double x);
+static void FlushBuffer(TextWriter *w);
+
+
+// Open outputfile (stdout if NULL or "-") for text output of a grid with
+//  nq[] points per dimension and n_values values per point, starting at
+//  origin[] with spacing dq, and write the N line. flags is either 0 or
+//  TEXT_NO_COORDINATES.
+TextWriter * TextOutputOpen(char *outputfile, const int *nq, const double *origin, double dq,
+                            int dimension, int n_values, int flags){
+
+    int i, k;
+    char entry[_MaxEntryLength_];
+    TextWriter * w = NULL;
+
+    w = calloc(1, sizeof(TextWriter));
+    if(w != NULL){
+        w->nq           = malloc(dimension * sizeof(int));
+        w->index        = calloc(dimension, sizeof(int));
+        w->origin       = malloc(dimension * sizeof(double));
+        w->coord_text   = calloc(dimension, sizeof(char*));
+        w->coord_length = calloc(dimension, sizeof(unsigned char*));
+        w->buffer       = malloc(_OutputBufferSize_);
+    }
+    if(w == NULL || w->nq == NULL || w->index == NULL || w->buffer == NULL
+    || w->origin == NULL || w->coord_text == NULL || w->coord_length == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "output buffer");
+        exit(2);
+    }
+
+    if(outputfile == NULL || strcmp(outputfile, "-") == 0){
+        w->fd = STDOUT_FILENO;
+    }else{
+        w->fd = open(outputfile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if(w->fd < 0){
+        fprintf(stderr,
+            "\n(-) ERROR opening output-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , outputfile
+        );
+        exit(1);
+    }
+
+    w->dimension   = dimension;
+    w->n_values    = n_values;
+    w->coordinates = !(flags & TEXT_NO_COORDINATES);
+    w->dq          = dq;
+    for(i = 0; i < dimension; ++i){
+        w->nq[i]     = nq[i];
+        w->origin[i] = origin[i];
+    }
+
+// format all coordinates of each dimension once, coordinates exceeding
+//  their slot are marked by a length of 0 and formatted on the fly
+    for(i = 0; i < dimension && w->coordinates; ++i){
+        w->coord_text[i]   = malloc((size_t)nq[i] * _CoordSlotLength_);
+        w->coord_length[i] = malloc(nq[i]);
+        if(w->coord_text[i] == NULL || w->coord_length[i] == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "coordinate table");
+            exit(2);
+        }
+        for(k = 0; k < nq[i]; ++k){
+            entry[0] = '\t';
+            w->coord_length[i][k] = 1 + FormatFixed12(entry + 1, origin[i] + (double)k * dq);
+            if(w->coord_length[i][k] > _CoordSlotLength_){
+                w->coord_length[i][k] = 0;
+            }
+            memcpy(w->coord_text[i] + (size_t)k * _CoordSlotLength_, entry, _CoordSlotLength_);
+        }
+    }
+
+// N line
+    w->used = sprintf(w->buffer, "N");
+    for(i = 0; i < dimension; ++i){
+        w->used += sprintf(w->buffer + w->used, "\t% d", nq[i]);
+    }
+    w->buffer[w->used++] = '\n';
+
+    return w;
+}
+
+
+// Append the values v[0..n*n_values) of the next n points
+void TextOutputWrite(TextWriter *w, const double *v, size_t n){
+
+    int j, k;
+    size_t i;
+    char * p = NULL;
+
+    for(i = 0; i < n; ++i){
+
+        if(w->used + (w->dimension + w->n_values + 1) * _MaxEntryLength_ > _OutputBufferSize_){
+            FlushBuffer(w);
+        }
+        p = w->buffer + w->used;
+
+    // add one blank line per trailing zero of the multi-index
+        for(k = w->dimension-1; k >= 0 && w->index[k] == 0; --k){
+            *p++ = '\n';
+        }
+
+    // actual output
+        for(j = 0; j < w->dimension && w->coordinates; ++j){
+            k = w->index[j];
+            if(w->coord_length[j][k] > 0){
+                memcpy(p, w->coord_text[j] + (size_t)k * _CoordSlotLength_, _CoordSlotLength_);
+                p += w->coord_length[j][k];
+            }else{
+                *p++ = '\t';
+                p += FormatFixed12(p, w->origin[j] + (double)k * w->dq);
+            }
+        }
+        for(j = 0; j < w->n_values; ++j){
+            *p++ = '\t';
+            p += FormatFixed12(p, v[i * w->n_values + j]);
+        }
+        *p++ = '\n';
+
+        w->used = p - w->buffer;
+
+    // increment multi-index
+        for(k = w->dimension-1; k >= 0; --k){
+            if(++w->index[k] < w->nq[k]) break;
+            w->index[k] = 0;
+        }
+    }
+}
+
+
+// Write n scattered points, one line with the <dimension> coordinates x
+//  and the n_values values V per point (formatted as the text grid output)
+int PointOutputFunction(char *outputfile, const double *x, const double *V, int n, int dimension, int n_values){
+
+    int i, j;
+    char * p = NULL;
+    TextWriter w;
+
+    memset(&w, 0, sizeof(TextWriter));
+    w.buffer = malloc(_OutputBufferSize_);
+    if(w.buffer == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "output buffer");
+        exit(2);
+    }
+    if(outputfile == NULL || strcmp(outputfile, "-") == 0){
+        w.fd = STDOUT_FILENO;
+    }else{
+        w.fd = open(outputfile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if(w.fd < 0){
+        fprintf(stderr,
+            "\n(-) ERROR opening output-file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , outputfile
+        );
+        exit(1);
+    }
+
+    for(i = 0; i < n; ++i){
+        if(w.used + (dimension + n_values + 1) * _MaxEntryLength_ > _OutputBufferSize_){
+            FlushBuffer(&w);
+        }
+        p = w.buffer + w.used;
+        for(j = 0; j < dimension; ++j){
+            *p++ = '\t';
+            p += FormatFixed12(p, x[(size_t)i * dimension + j]);
+        }
+        for(j = 0; j < n_values; ++j){
+            *p++ = '\t';
+            p += FormatFixed12(p, V[(size_t)i * n_values + j]);
+        }
+        *p++ = '\n';
+        w.used = p - w.buffer;
+    }
+
+    FlushBuffer(&w);
+    if(w.fd != STDOUT_FILENO && close(w.fd) != 0){
+        w.failed = 1;
+    }
+    free(w.buffer);
+    if(w.failed){
+        fprintf(stderr, "\n(-) ERROR writing text output\n    Exiting...\n\n");
+        exit(1);
+    }
+    return n;
+}
+
+
+// Flush remaining output and close the file, returns 0 on success
+int TextOutputClose(TextWriter *w){
+
+    int i, failed;
+
+    FlushBuffer(w);
+    if(w->fd != STDOUT_FILENO && close(w->fd) != 0){
+        w->failed = 1;
+    }
+    failed = w->failed;
+
+    for(i = 0; i < w->dimension; ++i){
+        free(w->coord_text[i]);
+        free(w->coord_length[i]);
+    }
+    free(w->coord_text);
+    free(w->coord_length);
+    free(w->origin);
+    free(w->nq);
+    free(w->index);
+    free(w->buffer);
+    free(w);
+
+    if(failed){
+        fprintf(stderr, "\n(-) ERROR writing text output\n    Exiting...\n\n");
+        exit(1);
+    }
+    return 0;
+}
+
+
+static void FlushBuffer(TextWriter *w){
+
+    ssize_t n;
+    char * p = w->buffer;
+
+    while(w->used > 0 && !w->failed){
+        n = write(w->fd, p, w->used);
+        if(n <= 0){
+            w->failed = 1;
+            break;
+        }
+        p       += n;
+        w->used -= n;
+    }
+    w->used = 0;
+}
+
+
+/* Fixed point formatting equivalent to printf("% 16.12lf", x):
+//{{{
+    A finite double is x = m 2^e with an integer mantissa m < 2^53. For e < 0
+    the exact value of x 10^12 is m 10^12 / 2^-e, where m 10^12 < 2^93 fits
+    into a 128 bit integer. The quotient is rounded to nearest with ties to
+    even (as glibc does in the default rounding mode) and split into the
+    integer part and the twelve decimals. Integers (e >= 0) up to 2^63 have
+    no decimals at all. Everything else (huge numbers, nan, inf) is handed
+    over to snprintf. The sign is kept for negative numbers rounding to zero
+    and -0.0, positive numbers get a leading blank, and the result is right
+    aligned to 16 characters. Returns the number of written characters.
+//}}}*/
+static int FormatFixed12(char *dst, double x){
+
+    int e, length, n_int;
+    uint64_t m, int_part, frac_part;
+    unsigned __int128 scaled, rem, half;
+    char digits[24];
+    char * p = dst;
+
+    if(!isfinite(x) || fabs(x) >= 9.0e18){
+        return snprintf(dst, _MaxEntryLength_, "% 16.12lf", x);
+    }
+
+// decompose x = m 2^e
+    m = (uint64_t)ldexp(frexp(fabs(x), &e), 53);
+    e -= 53;
+
+    if(m == 0){
+        int_part  = 0;
+        frac_part = 0;
+    }else if(e >= 0){
+        int_part  = m << e;
+        frac_part = 0;
+    }else{
+        scaled = (unsigned __int128)m * 1000000000000ULL;
+        if(-e >= 128){
+            scaled = 0;
+        }else{
+            rem    = scaled & (((unsigned __int128)1 << -e) - 1);
+            half   = (unsigned __int128)1 << (-e - 1);
+            scaled = scaled >> -e;
+            if(rem > half || (rem == half && (scaled & 1))){
+                ++scaled;
+            }
+        }
+        int_part  = (uint64_t)(scaled / 1000000000000ULL);
+        frac_part = (uint64_t)(scaled % 1000000000000ULL);
+    }
+
+// integer digits in reverse order
+    n_int = 0;
+    do{
+        digits[n_int++] = '0' + int_part % 10;
+        int_part /= 10;
+    }while(int_part > 0);
+
+// padding and sign
+    length = 1 + n_int + 1 + 12;
+    for(; length < 16; ++length){
+        *p++ = ' ';
+    }
+    *p++ = signbit(x) ? '-' : ' ';
+
+    while(n_int > 0){
+        *p++ = digits[--n_int];
+    }
+    *p++ = '.';
+    for(e = 11; e >= 0; --e){
+        p[e] = '0' + frac_part % 10;
+        frac_part /= 10;
+    }
+    p += 12;
+
+    return p - dst;
+}
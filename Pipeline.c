@@ -0,0 +1,201 @@
+#define _GNU_SOURCE
+#define _BlockValues_ (1 << 18)
+#define _QueueLength_ 4
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "nx1dInterpolator.h"
+#include "nx1dIO.h"
+
+/* Pipelined output:
+//{{{
+    Instead of writing the interpolated grid after the last pass, the last
+    pass is executed block by block (see "Pipelined execution" in
+    nx1dInterpolator.c) and every finished block is written by a writer
+    thread while the next blocks are computed. The blocks of about
+    _BlockValues_ values circulate through a ring of _QueueLength_ buffers:
+
+        compute:  acquire the next free buffer (waits while all buffers are
+                  filled), let the plan fill it, release it as filled
+        writer:   write the oldest filled buffer (text or binary), then
+                  hand it back as free
+
+    Only the ring, not the interpolated grid, is held in memory. The blocks
+    are the superordinate blocks of the last pass, a last pass over
+    dimension 0 has a single block and nothing to overlap. Unless the pass
+    order is given, such a last pass is therefore swapped with the one
+    before; the cost order of the other passes is kept (moving the last
+    dimension to the last pass instead turned out about twice as expensive,
+    its contiguous lines write the whole grid).
+//}}}*/
+typedef struct Pipeline {
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    double * block[_QueueLength_];
+    size_t   n_points[_QueueLength_];   // number of points of the filled blocks
+    int      length;                    // number of buffers of the ring
+    int      head;                      // oldest filled block
+    int      n_filled;                  // number of filled blocks (including the one being written)
+    int      done;                      // set after the last block
+    int      n_values;
+    int      fd;                        // binary output
+    int      failed;
+    TextWriter * writer;                // text output (NULL for binary output)
+} Pipeline;
+
+// Internal prototypes
+static double * AcquireBlock(void *data);
+static void     ReleaseBlock(double *block, size_t n_points, void *data);
+static void   * WriteBlocks(void *data);
+
+
+// Interpolate v by plan and write the result to outputfile (stdout if NULL or "-")
+//  while it is computed. Returns the number of interpolated points.
+size_t nx1dPipelinedInterpolation(nx1dPlan *plan, const double *v, char *order_list, const double *origin,
+                                  double dq, int n_spline, int dimension, int n_values, char *outputfile,
+                                  int binary_out, int text_flags){
+
+    int i;
+    size_t nn_points, block_points;
+    int * nq_new = NULL;
+    int * order  = NULL;
+    pthread_t writer;
+    Pipeline pipe;
+
+    nq_new = malloc(dimension * sizeof(int));
+    order  = malloc(dimension * sizeof(int));
+    if(nq_new == NULL || order == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "grid arrays");
+        exit(2);
+    }
+
+// a last pass over dimension 0 is swapped with the one before
+    if(order_list == NULL && dimension > 1){
+        CheckPlanError(nx1dPlanGetOrder(plan, order));
+        if(order[dimension-1] == 0){
+            order[dimension-1] = order[dimension-2];
+            order[dimension-2] = 0;
+            CheckPlanError(nx1dPlanSetOrder(plan, order));
+        }
+    }
+    nn_points    = nx1dPlanPoints(plan, nq_new);
+    block_points = nx1dPlanBlockPoints(plan, (_BlockValues_ / n_values > 0) ? _BlockValues_ / n_values : 1);
+
+// no more buffers than blocks
+    memset(&pipe, 0, sizeof(pipe));
+    pipe.n_values = n_values;
+    pipe.length   = (nn_points / block_points < _QueueLength_) ? (int)(nn_points / block_points) : _QueueLength_;
+    if(pipe.length < 1) pipe.length = 1;
+    for(i = 0; i < pipe.length; ++i){
+        pipe.block[i] = malloc(block_points * n_values * sizeof(double));
+        if(pipe.block[i] == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "output blocks");
+            exit(2);
+        }
+    }
+    if(binary_out){
+        pipe.fd = BinaryOutputOpen(outputfile, nq_new, origin, dq, n_spline, dimension, n_values);
+    }else{
+        pipe.writer = TextOutputOpen(outputfile, nq_new, origin, dq, dimension, n_values, text_flags);
+    }
+
+    pthread_mutex_init(&pipe.lock, NULL);
+    pthread_cond_init(&pipe.changed, NULL);
+    if(pthread_create(&writer, NULL, WriteBlocks, &pipe) != 0){
+        fprintf(stderr, "\n(-) ERROR creating the writer thread\n    Aborting...\n\n");
+        exit(1);
+    }
+
+    CheckPlanError(nx1dPlanExecuteBlocks(plan, v, block_points, AcquireBlock, ReleaseBlock, &pipe));
+
+    pthread_mutex_lock(&pipe.lock);
+    pipe.done = 1;
+    pthread_cond_broadcast(&pipe.changed);
+    pthread_mutex_unlock(&pipe.lock);
+    pthread_join(writer, NULL);
+
+    if(binary_out){
+        BinaryOutputClose(pipe.fd, outputfile, pipe.failed);
+    }else{
+        TextOutputClose(pipe.writer);
+    }
+
+    pthread_cond_destroy(&pipe.changed);
+    pthread_mutex_destroy(&pipe.lock);
+    for(i = 0; i < pipe.length; ++i){
+        free(pipe.block[i]);
+    }
+    free(nq_new);
+    free(order);
+
+    return nn_points;
+}
+
+
+// Next free buffer of the ring, waits while all buffers are filled
+static double * AcquireBlock(void *data){
+
+    Pipeline * pipe = data;
+    double * block  = NULL;
+
+    pthread_mutex_lock(&pipe->lock);
+    while(pipe->n_filled == pipe->length){
+        pthread_cond_wait(&pipe->changed, &pipe->lock);
+    }
+    block = pipe->block[(pipe->head + pipe->n_filled) % pipe->length];
+    pthread_mutex_unlock(&pipe->lock);
+
+    return block;
+}
+
+
+// Mark the buffer of the last AcquireBlock() as filled with n_points points
+static void ReleaseBlock(double *block, size_t n_points, void *data){
+
+    Pipeline * pipe = data;
+
+    (void)block;
+    pthread_mutex_lock(&pipe->lock);
+    pipe->n_points[(pipe->head + pipe->n_filled) % pipe->length] = n_points;
+    pipe->n_filled++;
+    pthread_cond_broadcast(&pipe->changed);
+    pthread_mutex_unlock(&pipe->lock);
+}
+
+
+// Writer thread: write the filled buffers in order until the last one is done
+static void * WriteBlocks(void *data){
+
+    int head;
+    Pipeline * pipe = data;
+
+    for(;;){
+        pthread_mutex_lock(&pipe->lock);
+        while(pipe->n_filled == 0 && !pipe->done){
+            pthread_cond_wait(&pipe->changed, &pipe->lock);
+        }
+        if(pipe->n_filled == 0){
+            pthread_mutex_unlock(&pipe->lock);
+            break;
+        }
+        head = pipe->head;
+        pthread_mutex_unlock(&pipe->lock);
+
+    // the buffer stays filled while it is written
+        if(pipe->writer != NULL){
+            TextOutputWrite(pipe->writer, pipe->block[head], pipe->n_points[head]);
+        }else if(!pipe->failed){
+            pipe->failed = BinaryOutputBlock(pipe->fd, pipe->block[head], pipe->n_points[head] * pipe->n_values, -1);
+        }
+
+        pthread_mutex_lock(&pipe->lock);
+        pipe->head = (head + 1) % pipe->length;
+        pipe->n_filled--;
+        pthread_cond_broadcast(&pipe->changed);
+        pthread_mutex_unlock(&pipe->lock);
+    }
+    return NULL;
+}
@@ -0,0 +1,185 @@
+#define _GNU_SOURCE
+#define _MaxProfileStages_ 16
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "nx1dInterpolator.h"
+#include "nx1dIO.h"
+
+#ifdef NX1D_PROFILE
+/* Stage profiling (make PPF=-DNX1D_PROFILE):
+//{{{
+    ProfileEnable() switches the profiling on (-R table|json or the
+    environment variable NX1D_PROFILE=table|json) and registers the report,
+    which is written to stderr when the program exits. main() records the
+    wall time, the bytes of the file read or written and the peak resident
+    memory after every stage (ProfileStage), and ProfilePlan() copies the
+    statistics of the dimensional passes (nx1dPlanPassStats) after the
+    execution. Without NX1D_PROFILE neither this file nor the calls in
+    main() are compiled.
+//}}}*/
+typedef struct ProfileEntry {
+    const char * name;
+    double seconds;
+    double bytes;           // bytes read or written by the stage, -1 if unknown
+    long   peak_kib;        // peak resident memory at the end of the stage
+} ProfileEntry;
+
+static struct {
+    int format;             // 0: off, PROFILE_TABLE or PROFILE_JSON
+    int n_stages;
+    int n_passes;
+    ProfileEntry stage[_MaxProfileStages_];
+    nx1dPassStats * pass;
+} profile;
+
+// Internal prototypes
+static void ProfileReport(void);
+static void PrintCounter(const char *format, double value, int json);
+
+
+// Switch profiling on for format "table" or "json" (NULL, "" and "off"
+//  keep it off), returns 1 if profiling is on
+int ProfileEnable(const char *format){
+
+    if(format == NULL || format[0] == '\0' || strcmp(format, "off") == 0){
+        return 0;
+    }
+    if(profile.format == 0){
+        atexit(ProfileReport);
+    }
+    profile.format = (strcmp(format, "json") == 0) ? PROFILE_JSON : PROFILE_TABLE;
+
+    return 1;
+}
+
+
+// Wall clock time in seconds
+double ProfileTime(void){
+
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9 * t.tv_nsec;
+}
+
+
+// Record the stage <name> started at <start>, the bytes of the stage are
+//  the size of file (NULL: none, "-": stdout if it is a regular file)
+void ProfileStage(const char *name, double start, const char *file){
+
+    struct stat st;
+    struct rusage usage;
+    ProfileEntry * e = NULL;
+
+    if(profile.format == 0 || profile.n_stages == _MaxProfileStages_) return;
+
+    e = &profile.stage[profile.n_stages++];
+    e->name    = name;
+    e->seconds = ProfileTime() - start;
+    e->bytes   = -1.0;
+    if(file != NULL && strcmp(file, "-") == 0){
+        if(fstat(STDOUT_FILENO, &st) == 0 && S_ISREG(st.st_mode)) e->bytes = st.st_size;
+    }else if(file != NULL){
+        if(stat(file, &st) == 0) e->bytes = st.st_size;
+    }
+    e->peak_kib = (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : -1;
+}
+
+
+// Copy the pass statistics of the last execution of plan
+void ProfilePlan(const nx1dPlan *plan, int dimension){
+
+    if(profile.format == 0) return;
+
+    free(profile.pass);
+    profile.pass     = malloc(dimension * sizeof(nx1dPassStats));
+    profile.n_passes = (profile.pass != NULL) ? dimension : 0;
+    if(profile.pass != NULL){
+        nx1dPlanPassStats(plan, profile.pass);
+    }
+}
+
+
+static void ProfileReport(void){
+
+    int i, json = (profile.format == PROFILE_JSON);
+    nx1dPassStats * s = NULL;
+    ProfileEntry * e = NULL;
+
+    if(json){
+        fprintf(stderr, "{\n  \"stages\": [\n");
+    }else{
+        fprintf(stderr, "\n(*) Profile"
+                        "\n    %-10s %12s %12s %10s %14s\n", "stage", "seconds", "MB", "MB/s", "peak RSS MiB");
+    }
+    for(i = 0; i < profile.n_stages; ++i){
+        e = &profile.stage[i];
+        if(json){
+            fprintf(stderr, "    {\"stage\": \"%s\", \"seconds\": %.6e, \"bytes\": ", e->name, e->seconds);
+            PrintCounter("%.0f", e->bytes, 1);
+            fprintf(stderr, ", \"peak_rss_kib\": %ld}%s\n", e->peak_kib, (i < profile.n_stages-1) ? "," : "");
+        }else{
+            fprintf(stderr, "    %-10s %12.6f ", e->name, e->seconds);
+            PrintCounter("%12.3f", (e->bytes < 0.0) ? -1.0 : e->bytes * 1.0e-6, 0);
+            PrintCounter(" %10.1f", (e->bytes < 0.0) ? -1.0 : e->bytes * 1.0e-6 / e->seconds, 0);
+            fprintf(stderr, " %14.1f\n", e->peak_kib / 1024.0);
+        }
+    }
+
+    if(json){
+        fprintf(stderr, "  ],\n  \"passes\": [\n");
+    }else if(profile.n_passes > 0){
+        fprintf(stderr, "\n    %-4s %4s %10s %12s %8s %10s %14s %14s %6s %14s\n", "pass", "dim", "lines", "seconds",
+                        "GB/s", "cpu s", "cycles", "instructions", "IPC", "cache misses");
+    }
+    for(i = 0; i < profile.n_passes; ++i){
+        s = &profile.pass[i];
+        if(json){
+            fprintf(stderr, "    {\"pass\": %d, \"dimension\": %d, \"lines\": %.0f, \"seconds\": %.6e, \"bytes\": %.0f"
+                          , i, s->dimension, s->lines, s->seconds, s->bytes);
+            fprintf(stderr, ", \"cpu_seconds\": ");  PrintCounter("%.6e", s->cpu_seconds, 1);
+            fprintf(stderr, ", \"cycles\": ");       PrintCounter("%.0f", s->cycles, 1);
+            fprintf(stderr, ", \"instructions\": "); PrintCounter("%.0f", s->instructions, 1);
+            fprintf(stderr, ", \"cache_misses\": "); PrintCounter("%.0f", s->cache_misses, 1);
+            fprintf(stderr, "}%s\n", (i < profile.n_passes-1) ? "," : "");
+        }else{
+            fprintf(stderr, "    %-4d %4d %10.0f %12.6f %8.2f", i, s->dimension, s->lines, s->seconds,
+                            s->bytes * 1.0e-9 / s->seconds);
+            PrintCounter(" %10.6f", s->cpu_seconds, 0);
+            PrintCounter(" %14.0f", s->cycles, 0);
+            PrintCounter(" %14.0f", s->instructions, 0);
+            PrintCounter(" %6.2f", (s->cycles > 0.0 && s->instructions >= 0.0) ? s->instructions / s->cycles : -1.0, 0);
+            PrintCounter(" %14.0f", s->cache_misses, 0);
+            fprintf(stderr, "\n");
+        }
+    }
+    fprintf(stderr, json ? "  ]\n}\n" : "\n");
+
+    free(profile.pass);
+}
+
+
+// Print value with format, unavailable (negative) values as n/a or null
+static void PrintCounter(const char *format, double value, int json){
+
+    int width;
+
+    if(value >= 0.0){
+        fprintf(stderr, format, value);
+    }else if(json){
+        fprintf(stderr, "null");
+    }else{
+    // right align n/a to the field width of format
+        width = (format[0] == ' ') ? 1 : 0;
+        width += atoi(format + width + 1);
+        fprintf(stderr, "%*s", width, "n/a");
+    }
+}
+#endif
@@ -0,0 +1,278 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "nx1dInterpolator.h"
+#include "nx1dIO.h"
+
+/* Out-of-core interpolation:
+//{{{
+    The tensor product interpolation is separable, hence the order of the
+    dimensional passes is arbitrary. Processing the subordinate dimensions
+    1..d-1 first makes every slab of constant index i0 along dimension 0
+    independent of all others:
+
+    Pass A: every input slab (nq[1]*...*nq[d-1] points) is interpolated
+            and appended to a scratch file next to the output file, which
+            finally holds an array of nq[0] x PP points (PP being the
+            interpolated slab size). A slab whose interpolation fits into
+            the memory budget is interpolated by a (d-1)-dimensional plan,
+            larger slabs are streamed into the scratch file by the same
+            two passes one dimension lower (StreamGrid calls itself).
+
+    Pass B: the scratch file is mapped and split into chunks of w columns.
+            For each chunk the nq[0] rows of w contiguous values are
+            gathered into a tile, interpolated along dimension 0 by a
+            1-dimensional plan with w values per point, and the resulting
+            nq_new[0] rows are written to their final position in the
+            binary output file.
+
+    The memory budget covers the interpolated slabs with the intermediate
+    grids of their plans and the tiles, of which only one is held in memory
+    at any time. It does not cover the input grid, which is read as a whole,
+    nor the pages of the mapped scratch files, which the kernel may drop at
+    will. A tile holds at least one line along dimension 0 (w = 1), so the
+    budget is exceeded if a single line doesn't fit. The scratch files are
+    unlinked right after their creation so they vanish when the process
+    ends.
+//}}}*/
+
+// Internal prototypes
+static int    StreamGrid(const double *v, const int *nq, double dq, int dimension, int n_spline, int n_threads,
+                         int engine, size_t memory, const char *outputfile, int fd, off_t offset);
+static size_t PlanMemory(const int *nq, int dimension, int n_spline);
+static int    CreateScratchFile(const char *outputfile);
+
+
+// Interpolate the grid v (nq[], origin[], dq) and stream the result into the
+//  binary file outputfile, the interpolated slabs and tiles use about
+//  <memory> bytes of memory. Returns the number of interpolated points.
+size_t nx1dStreamInterpolation(const double *v, const int *nq, const double *origin, double dq,
+                               int dimension, int n_spline, int n_threads, int engine, size_t memory,
+                               char *outputfile){
+
+    int i, fd;
+    int failed = 0;
+    size_t nn_points;
+    int * nq_new = NULL;
+    size_t header_size = BinaryHeaderSize(dimension);
+
+    if(outputfile == NULL || strcmp(outputfile, "-") == 0 || !IsBinaryFile(outputfile)){
+        fprintf(stderr,
+            "\n(-) ERROR in streaming interpolation:"
+            "\n    The output has to be written to a binary (.nx1d) file."
+            "\n    Aborting..."
+            "\n\n"
+        );
+        exit(1);
+    }
+
+    nq_new = malloc(dimension * sizeof(int));
+    if(nq_new == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "grid arrays");
+        exit(2);
+    }
+    for(i = 0, nn_points = 1; i < dimension; ++i){
+        nq_new[i]  = (nq[i] - 1) * (n_spline + 1) + 1;
+        nn_points *= nq_new[i];
+    }
+
+    fd = BinaryOutputOpen(outputfile, nq_new, origin, dq / (double)(n_spline + 1), n_spline, dimension, 1);
+    if(ftruncate(fd, header_size + nn_points * sizeof(double)) != 0){
+        failed = 1;
+    }
+    if(!failed){
+        failed = StreamGrid(v, nq, dq, dimension, n_spline, n_threads, engine, memory, outputfile, fd, header_size);
+    }
+    BinaryOutputClose(fd, outputfile, failed);
+
+    free(nq_new);
+
+    return nn_points;
+}
+
+
+// Interpolate the grid v (nq[], dq) and write the result to fd at offset
+//  (see "Out-of-core interpolation"), returns 1 if writing failed
+static int StreamGrid(const double *v, const int *nq, double dq, int dimension, int n_spline, int n_threads,
+                      int engine, size_t memory, const char *outputfile, int fd, off_t offset){
+
+    int i, r;
+    int scratch_fd = -1;
+    int failed = 0;
+    int in_memory;          // 1 if the slabs are interpolated by a plan
+    int nn_0 = (nq[0] - 1) * (n_spline + 1) + 1;
+    size_t c, j;
+    size_t n_slab;          // number of input points of one slab
+    size_t nn_slab;         // number of interpolated points of one slab
+    size_t width, n_width;  // chunk width of pass B, at most INT_MAX values per point
+    const double * src = NULL;
+    double * slab  = NULL;
+    double * tile  = NULL;
+    double * aux   = NULL;
+    nx1dPlan * inner = NULL;
+    nx1dPlan * outer = NULL;
+
+    for(i = 1, n_slab = 1, nn_slab = 1; i < dimension; ++i){
+        n_slab  *= nq[i];
+        nn_slab *= (nq[i] - 1) * (n_spline + 1) + 1;
+    }
+
+
+//----------------------------------------------------------------------
+//  Pass A   Pass A   Pass A   Pass A   Pass A   Pass A   Pass A   Pass A
+//----------------------------------------------------------------------
+    if(dimension > 1){
+
+        scratch_fd = CreateScratchFile(outputfile);
+        in_memory  = (dimension == 2 || PlanMemory(nq + 1, dimension - 1, n_spline) <= memory);
+
+        if(in_memory){
+            CheckPlanError(nx1dPlanCreate(&inner, nq + 1, dq, dimension - 1, n_spline, 1));
+            CheckPlanError(nx1dPlanSetThreads(inner, n_threads));
+            CheckPlanError(nx1dPlanSetEngine(inner, engine));
+
+            slab = malloc(nn_slab * sizeof(double));
+            if(slab == NULL){
+                fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "slab");
+                exit(2);
+            }
+        }
+
+        for(i = 0; i < nq[0] && !failed; ++i){
+            if(in_memory){
+                CheckPlanError(nx1dPlanExecute(inner, v + i * n_slab, slab));
+                failed = BinaryOutputBlock(scratch_fd, slab, nn_slab, (off_t)(i * nn_slab * sizeof(double)));
+            }else{
+                failed = StreamGrid(v + i * n_slab, nq + 1, dq, dimension - 1, n_spline, n_threads, engine, memory,
+                                    outputfile, scratch_fd, (off_t)(i * nn_slab * sizeof(double)));
+            }
+        }
+
+        nx1dPlanDestroy(inner);
+        free(slab);
+
+        src = mmap(NULL, (size_t)nq[0] * nn_slab * sizeof(double), PROT_READ, MAP_SHARED, scratch_fd, 0);
+        if(failed || src == MAP_FAILED){
+            fprintf(stderr,
+                "\n(-) ERROR in streaming interpolation:"
+                "\n    Writing or mapping the scratch file next to \"%s\" failed."
+                "\n    Aborting..."
+                "\n\n"
+                , outputfile
+            );
+            exit(1);
+        }
+        madvise((void*)src, (size_t)nq[0] * nn_slab * sizeof(double), MADV_SEQUENTIAL);
+    }else{
+        src = v;
+    }
+
+
+//----------------------------------------------------------------------
+//  Pass B   Pass B   Pass B   Pass B   Pass B   Pass B   Pass B   Pass B
+//----------------------------------------------------------------------
+// a chunk of width w needs nq[0]*w values for the tile and nq_new[0]*w
+//  values for the result (a 1-dimensional plan has no intermediate grids)
+    width = memory / ((size_t)(nq[0] + nn_0) * sizeof(double));
+    if(width < 1)       width = 1;
+    if(width > nn_slab) width = nn_slab;
+    if(width > INT_MAX) width = INT_MAX;
+
+    tile = malloc((size_t)nq[0] * width * sizeof(double));
+    aux  = malloc((size_t)nn_0  * width * sizeof(double));
+    if(tile == NULL || aux == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "tile");
+        exit(2);
+    }
+
+    for(c = 0; c < nn_slab && !failed; c += n_width){
+
+        n_width = (nn_slab - c < width) ? nn_slab - c : width;
+
+    // the plan of the last (smaller) chunk differs
+        if(outer == NULL || n_width != width){
+            nx1dPlanDestroy(outer);
+            CheckPlanError(nx1dPlanCreate(&outer, nq, dq, 1, n_spline, n_width));
+            CheckPlanError(nx1dPlanSetThreads(outer, n_threads));
+            CheckPlanError(nx1dPlanSetEngine(outer, engine));
+        }
+
+        for(j = 0; j < (size_t)nq[0]; ++j){
+            memcpy(tile + j * n_width, src + j * nn_slab + c, n_width * sizeof(double));
+        }
+
+        CheckPlanError(nx1dPlanExecute(outer, tile, aux));
+
+        for(r = 0; r < nn_0 && !failed; ++r){
+            failed = BinaryOutputBlock(fd, aux + (size_t)r * n_width, n_width,
+                                       offset + (off_t)(((size_t)r * nn_slab + c) * sizeof(double)));
+        }
+    }
+
+    nx1dPlanDestroy(outer);
+    free(tile);
+    free(aux);
+    if(dimension > 1){
+        munmap((void*)src, (size_t)nq[0] * nn_slab * sizeof(double));
+        close(scratch_fd);
+    }
+
+    return failed;
+}
+
+
+// Upper bound of the bytes a plan of the grid nq[] allocates for its
+//  result and intermediate grids: every intermediate grid lacks the
+//  interpolation of at least one dimension j, i.e. it is at most
+//  nq[j]/nq_new[j] of the result
+static size_t PlanMemory(const int *nq, int dimension, int n_spline){
+
+    int i;
+    size_t nn_points, n_intermediate, max_intermediate;
+
+    for(i = 0, nn_points = 1; i < dimension; ++i){
+        nn_points *= (nq[i] - 1) * (n_spline + 1) + 1;
+    }
+    for(i = 0, max_intermediate = 0; i < dimension && dimension > 1; ++i){
+        n_intermediate = nn_points / ((nq[i] - 1) * (n_spline + 1) + 1) * nq[i];
+        if(n_intermediate > max_intermediate) max_intermediate = n_intermediate;
+    }
+    return (nn_points + 2 * max_intermediate) * sizeof(double);
+}
+
+
+// Create an anonymous scratch file in the directory of outputfile
+static int CreateScratchFile(const char *outputfile){
+
+    int fd;
+    char * name = NULL;
+
+    name = malloc(strlen(outputfile) + 16);
+    if(name == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "file name");
+        exit(2);
+    }
+    sprintf(name, "%s.tmp.XXXXXX", outputfile);
+
+    fd = mkstemp(name);
+    if(fd < 0){
+        fprintf(stderr,
+            "\n(-) ERROR creating scratch file: \"%s\""
+            "\n    Exiting..."
+            "\n\n"
+            , name
+        );
+        exit(1);
+    }
+    unlink(name);
+    free(name);
+
+    return fd;
+}
@@ -0,0 +1,222 @@
+#define _GNU_SOURCE
+#define _NodeTolerance_ 1.0e-6
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "nx1dInterpolator.h"
+#include "nx1dIO.h"
+
+/* Incremental re-interpolation:
+//{{{
+    When only a few input points of a surface are recomputed, the previous
+    result is corrected instead of interpolating the whole grid again (see
+    "Incremental update" in nx1dInterpolator.c). The delta file lists the
+    changed input points in the input format, i.e. <dimension> coordinates
+    and the n_values new values per line.
+
+    The previous result (binary or text with coordinates) defines the grid:
+    the input grid has every (n_spline+1)-th point of it, so its nq, origin
+    and dq follow from nq_new, origin and the interpolated spacing, and its
+    values are the values of the result at these nodes. Binary results carry
+    n_spline and n_values in their header. The change of a point is its new
+    value minus the value of the previous result at its node.
+
+    If the output file is the (binary) previous result itself, the file is
+    mapped writable and updated in place. Only the pages of the boxes around
+    the changed points are then read and written, instead of the whole grid.
+
+    Every change is taken relative to the previous result, so a point listed
+    twice would be moved twice. Such delta files are rejected.
+//}}}*/
+
+// node of a changed point and its number in the delta file
+typedef struct ChangedNode {
+    size_t node;
+    int    c;
+} ChangedNode;
+
+// Internal prototypes
+static int CompareNodes(const void *a, const void *b);
+
+int nx1dUpdateInterpolation(char *previousfile, char *deltafile, int dimension, int n_spline, int n_values,
+                            int n_threads, int engine, char *order_list, char *outputfile,
+                            int binary_out, int text_flags){
+
+    int i, k, s, c;
+    int n_changes, on_grid;
+    int in_place = 0;
+    size_t n_points, nn_points, node, stride;
+    int * nq     = NULL;
+    int * nq_new = NULL;
+    int * nq_delta = NULL;
+    int * index  = NULL;
+    double dq, dq_new, x;
+    double * origin = NULL;
+    double * yy     = NULL;
+    double * mapped = NULL;
+    double * delta  = NULL;
+    double * v_delta = NULL;
+    double ** q       = NULL;
+    double ** q_delta = NULL;
+    ChangedNode * nodes = NULL;
+    BinaryMap map = {NULL, 0, 0};
+    TextWriter * writer = NULL;
+    nx1dPlan * plan = NULL;
+
+    nq      = calloc(dimension, sizeof(int));
+    nq_new  = calloc(dimension, sizeof(int));
+    nq_delta = calloc(dimension, sizeof(int));
+    origin  = calloc(dimension, sizeof(double));
+    q       = calloc(dimension, sizeof(double*));
+    q_delta = calloc(dimension, sizeof(double*));
+    if(nq == NULL || nq_new == NULL || nq_delta == NULL || origin == NULL || q == NULL || q_delta == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "grid arrays");
+        exit(2);
+    }
+
+// previous result, it is updated in place or in a private copy
+    if(IsBinaryFile(previousfile)){
+        nn_points = BinaryInputFunction(previousfile, &map, nq_new, origin, &dq_new, &n_spline, &n_values,
+                                        &mapped, dimension);
+        if(outputfile != NULL && strcmp(outputfile, previousfile) == 0){
+            BinaryInputRelease(&map);
+            yy = BinaryMapWritable(previousfile, &map, nn_points * n_values, dimension);
+            in_place = (yy != NULL);
+            if(!in_place){
+                nn_points = BinaryInputFunction(previousfile, &map, nq_new, origin, &dq_new, &n_spline,
+                                                &n_values, &mapped, dimension);
+            }
+        }
+        if(!in_place){
+            yy = malloc((nn_points * n_values + 1) * sizeof(double));
+            if(yy == NULL){
+                fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "interpolated data");
+                exit(2);
+            }
+            memcpy(yy, mapped, nn_points * n_values * sizeof(double));
+            BinaryInputRelease(&map);
+        }
+    }else{
+        nn_points = InputFunction(previousfile, &q, nq_new, &yy, dimension, n_values);
+        dq_new = (nn_points > 1) ? q[dimension-1][1] - q[dimension-1][0] : 0.0;
+        for(i = 0; i < dimension; ++i){
+            origin[i] = (nn_points > 0) ? q[i][0] : 0.0;
+            free(q[i]); q[i] = NULL;
+        }
+    }
+
+// input grid of the previous result
+    dq = dq_new * (n_spline + 1);
+    for(i = 0, n_points = 1, stride = 1, on_grid = 1; i < dimension; ++i){
+        nq[i]     = (nq_new[i] - 1) / (n_spline + 1) + 1;
+        n_points *= nq[i];
+        stride   *= nq_new[i];
+        on_grid   = on_grid && (nq_new[i] - 1) % (n_spline + 1) == 0;
+    }
+    if(yy == NULL || !on_grid || stride != nn_points || !(dq > 0.0)){
+        fprintf(stderr,
+            "\n(-) ERROR reading data from previous result \"%s\"."
+            "\n    The file is no %d dimensional grid interpolated with n_spline = %d."
+            "\n    Aborting - please check your input..."
+            "\n\n"
+            , previousfile, dimension, n_spline
+        );
+        exit(1);
+    }
+
+// changed points, their grid indices and the change of their values
+    n_changes = InputFunction(deltafile, &q_delta, nq_delta, &v_delta, dimension, n_values);
+    index = malloc(((size_t)n_changes * dimension + 1) * sizeof(int));
+    delta = malloc(((size_t)n_changes * n_values + 1) * sizeof(double));
+    nodes = malloc(((size_t)n_changes + 1) * sizeof(ChangedNode));
+    if(index == NULL || delta == NULL || nodes == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "update arrays");
+        exit(2);
+    }
+    for(c = 0; c < n_changes; ++c){
+        for(k = dimension-1, node = 0, stride = 1; k >= 0; --k){
+            x = (q_delta[k][c] - origin[k]) / dq;
+            index[c * dimension + k] = (int)lround(x);
+            if(fabs(x - lround(x)) > _NodeTolerance_ || lround(x) < 0 || lround(x) >= nq[k]){
+                fprintf(stderr,
+                    "\n(-) ERROR reading data from delta file \"%s\"."
+                    "\n    Point number %d is no point of the input grid."
+                    "\n    Aborting - please check your input..."
+                    "\n\n"
+                    , deltafile, c
+                );
+                exit(1);
+            }
+            node   += (size_t)index[c * dimension + k] * (n_spline + 1) * stride;
+            stride *= nq_new[k];
+        }
+        for(s = 0; s < n_values; ++s){
+            delta[(size_t)c * n_values + s] = v_delta[(size_t)c * n_values + s] - yy[node * n_values + s];
+        }
+        nodes[c].node = node;
+        nodes[c].c    = c;
+    }
+
+// every point may only be changed once
+    qsort(nodes, n_changes, sizeof(ChangedNode), CompareNodes);
+    for(c = 1; c < n_changes; ++c){
+        if(nodes[c].node == nodes[c-1].node){
+            fprintf(stderr,
+                "\n(-) ERROR reading data from delta file \"%s\"."
+                "\n    Point number %d and point number %d are the same point of the input grid."
+                "\n    Aborting - please check your input..."
+                "\n\n"
+                , deltafile, nodes[c-1].c, nodes[c].c
+            );
+            exit(1);
+        }
+    }
+    free(nodes);
+
+    CheckPlanError(nx1dPlanCreate(&plan, nq, dq, dimension, n_spline, n_values));
+    SetupPlan(plan, dimension, n_threads, engine, order_list);
+    CheckPlanError(nx1dPlanUpdate(plan, index, delta, n_changes, yy));
+    nx1dPlanDestroy(plan);
+
+    if(in_place){
+        BinaryInputRelease(&map);
+        yy = NULL;
+    }else if(binary_out){
+        BinaryOutputFunction(outputfile, nq_new, origin, dq_new, n_spline, yy, dimension, n_values);
+    }else{
+        writer = TextOutputOpen(outputfile, nq_new, origin, dq_new, dimension, n_values, text_flags);
+        TextOutputWrite(writer, yy, nn_points);
+        TextOutputClose(writer);
+    }
+
+    for(i = 0; i < dimension; ++i){
+        free(q[i]);
+        free(q_delta[i]);
+    }
+    free(q);
+    free(q_delta);
+    free(v_delta);
+    free(index);
+    free(delta);
+    free(yy);
+    free(nq);
+    free(nq_new);
+    free(nq_delta);
+    free(origin);
+
+    return n_changes;
+}
+
+
+// Order of the changed points by node, equal nodes by their number
+static int CompareNodes(const void *a, const void *b){
+
+    const ChangedNode * x = a;
+    const ChangedNode * y = b;
+
+    if(x->node != y->node) return (x->node < y->node) ? -1 : 1;
+    return (x->c > y->c) - (x->c < y->c);
+}
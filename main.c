@@ -1,44 +1,376 @@
+#define _FloatBlock_ (1 << 16)
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
-int InputFunction(char *inputfile, double ***q, int *nq, double **v, int dimension);
-int nx1dInterpolation(double ** v, int * nq, double dq, int dimension, int n_spline);
+#include "nx1dInterpolator.h"
+#include "nx1dIO.h"
+
+static void PrintUsage(char *name){
+    fprintf(stderr,
+        "\nUsage: %s [-t threads] [-b] [-c] [-f] [-n n_values] [-d order] [-P precision] [-H pages] [-q] [-s MiB] [-O order] [-p pointfile] [-U previous] [-R format] [-o outputfile] inputfile [dimension] [n_spline]"
+        "\n       %s [-t threads] [-b] [-c] [-f] [-O order] -B batchfile [dimension] [n_spline]"
+        "\n"
+        "\n    -t <n>     number of threads (default: NX1D_NUM_THREADS or OMP_NUM_THREADS)"
+        "\n    -b         binary output (default for output files ending in .nx1d)"
+        "\n    -c         omit the coordinate columns of the text output"
+        "\n    -f         compute the spline coefficients with the recursive filter"
+        "\n               engine instead of the Thomas algorithm"
+        "\n    -n <n>     number of value columns of a text input (default: 1), all"
+        "\n               columns are interpolated together and written side by side"
+        "\n    -d <n>     derivative output: 1 writes the first derivatives of the values"
+        "\n               along dimension 0 .. dimension-1 after the values, 2 also the"
+        "\n               second ones after those (analytic derivatives of the spline)"
+        "\n    -B <file>  batch mode: interpolate all surfaces of the same grid listed"
+        "\n               in file, one \"inputfile outputfile\" pair per line, with a"
+        "\n               single plan (see Batch.c)"
+        "\n    -P <mode>  precision of the grid interpolation: double (default), float"
+        "\n               (float storage and arithmetic) or mixed (float storage,"
+        "\n               double arithmetic), -s and -p always use double"
+        "\n    -H <mode>  pages of the grids: thp (transparent huge pages, default),"
+        "\n               small (base pages only) or huge (explicit huge pages of the"
+        "\n               hugetlbfs pool, thp if the pool is too small)"
+        "\n    -q         pipelined output: the blocks of the last pass are written by a"
+        "\n               writer thread while later ones are computed, the result is"
+        "\n               never held in memory as a whole (see Pipeline.c)"
+        "\n    -s <MiB>   out-of-core interpolation, the intermediate results use about"
+        "\n               <MiB> of memory (at least one line along dimension 0), the"
+        "\n               input grid is held in memory in addition, requires a binary"
+        "\n               (.nx1d) output file"
+        "\n    -O <list>  comma separated order of the dimensional passes, e.g. 0,1,2"
+        "\n               (default: the order with the least estimated cost)"
+        "\n    -p <file>  evaluate the spline at the points listed in file (one point"
+        "\n               of <dimension> coordinates per line) instead of the dense grid"
+        "\n    -R <fmt>   report the time, bytes and peak memory of every stage and the"
+        "\n               statistics of every dimensional pass on stderr as table or"
+        "\n               json (default: NX1D_PROFILE), needs a build with"
+        "\n               -DNX1D_PROFILE"
+        "\n    -U <file>  incremental update: correct the previous result in file for"
+        "\n               the changed input points listed in inputfile (coordinates and"
+        "\n               new values), n_spline is read from binary results"
+        "\n    -o <file>  write output to file instead of stdout"
+        "\n"
+        "\n    Input files ending in .nx1d are read as binary grids."
+        "\n\n"
+        , name, name
+    );
+}
+
+// Abort on an error code of the interpolation library,
+//  allocation failures exit with 2, all others with 1
+void CheckPlanError(int error){
+
+    if(error == NX1D_SUCCESS) return;
+
+    fprintf(stderr,
+        "\n(-) ERROR in interpolation:"
+        "\n    %s"
+        "\n    Aborting..."
+        "\n\n"
+        , nx1dErrorString(error)
+    );
+    exit((error == NX1D_ERROR_MEMORY) ? 2 : 1);
+}
+
+// Write the interpolated grid yf of a float precision mode, the values
+//  are converted to double in blocks of at most _FloatBlock_ values
+static void FloatOutput(char *outputfile, int binary_out, int text_flags, const int *nq, const double *origin,
+                        double dq, int n_spline, const float *yf, size_t n_points, int dimension, int n_values){
+
+    int n_block;
+    size_t i, j;
+    int fd     = -1;
+    int failed = 0;
+    int block_points = (_FloatBlock_ / n_values > 0) ? _FloatBlock_ / n_values : 1;
+    double * block = NULL;
+    TextWriter * writer = NULL;
+
+    block = malloc((size_t)block_points * n_values * sizeof(double));
+    if(block == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "output block");
+        exit(2);
+    }
+    if(binary_out){
+        fd = BinaryOutputOpen(outputfile, nq, origin, dq, n_spline, dimension, n_values);
+    }else{
+        writer = TextOutputOpen(outputfile, nq, origin, dq, dimension, n_values, text_flags);
+    }
+
+    for(i = 0; i < n_points && !failed; i += n_block){
+        n_block = (n_points - i < (size_t)block_points) ? (int)(n_points - i) : block_points;
+        for(j = 0; j < (size_t)n_block * n_values; ++j){
+            block[j] = yf[i * n_values + j];
+        }
+        if(binary_out){
+            failed = BinaryOutputBlock(fd, block, (size_t)n_block * n_values, -1);
+        }else{
+            TextOutputWrite(writer, block, n_block);
+        }
+    }
+    free(block);
+
+    if(binary_out){
+        BinaryOutputClose(fd, outputfile, failed);
+    }else{
+        TextOutputClose(writer);
+    }
+}
+
+// Apply the thread count, coefficient engine and the comma separated pass
+//  order list (if not NULL) of the command line to plan
+void SetupPlan(nx1dPlan *plan, int dimension, int n_threads, int engine, char *order_list){
+
+    int i;
+    int * order = NULL;
+    char * next = NULL;
+
+    if(n_threads > 0){
+        CheckPlanError(nx1dPlanSetThreads(plan, n_threads));
+    }
+    CheckPlanError(nx1dPlanSetEngine(plan, engine));
+    if(order_list == NULL) return;
+
+    order = malloc(dimension * sizeof(int));
+    if(order == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "pass order");
+        exit(2);
+    }
+    for(i = 0, next = order_list; i < dimension; ++i){
+        order[i] = (int)strtol(next, &next, 10);
+        if(*next != (i < dimension-1 ? ',' : '\0')){
+            fprintf(stderr, "\n(-) ERROR: the pass order \"%s\" doesn't list %d dimensions\n    Aborting...\n\n"
+                           , order_list, dimension);
+            exit(1);
+        }
+        ++next;
+    }
+    CheckPlanError(nx1dPlanSetOrder(plan, order));
+    free(order);
+}
 
 int main(int argc, char **argv){
 
-    int i, j, k, l;
-    int jump;
+    int i;
+    size_t j, k;
 
 /* Input */
 
     int dimension = 2;
-    int n_points  = 0;
+    size_t n_points = 0;
     int n_spline  = 1;
+    int n_values  = 1;
+    int n_threads = 0;
+    int binary_in  = 0;
+    int binary_out = 0;
+    int text_flags = 0;
+    int engine     = NX1D_ENGINE_THOMAS;
+    int precision  = NX1D_PRECISION_DOUBLE;
+    int pages      = NX1D_PAGES_DEFAULT;
+    int pipelined  = 0;
+    int derivatives = 0;
+    int n_out;
+    int n_spline_in;            // n_spline stored in a binary input file (unused)
+    size_t memory  = 0;
+    int opt;
 
     double ** q = NULL;
     double  * v = NULL;
-    char    * inputfile = argv[1];
-    int     * nq = NULL;
+    double  * yy = NULL;
+    float   * vf = NULL;
+    float   * yf = NULL;
+    char    * inputfile  = NULL;
+    char    * outputfile = NULL;
+    char    * order_list = NULL;
+    char    * pointfile  = NULL;
+    char    * batchfile  = NULL;
+    char    * previousfile = NULL;
+    char    * profile_format = NULL;
+    int     * nq     = NULL;
+    int     * nq_new = NULL;
+    double  * origin = NULL;
+    double  * x      = NULL;
     double    dq;
+    nx1dPlan * plan = NULL;
+    nx1dSpline * spline = NULL;
+    BinaryMap map   = {NULL, 0, 0};
+    TextWriter * writer = NULL;
+#ifdef NX1D_PROFILE
+    int profile  = 0;
+    double start = 0.0;
+#endif
 
-    if(argc > 2){
-        dimension = atoi(argv[2]);
+// Options
+    while((opt = getopt(argc, argv, "t:bcfn:d:B:P:H:qs:O:p:U:R:o:")) != -1){
+        switch(opt){
+            case 't':
+                n_threads = atoi(optarg);
+                break;
+            case 'b':
+                binary_out = 1;
+                break;
+            case 'c':
+                text_flags |= TEXT_NO_COORDINATES;
+                break;
+            case 'f':
+                engine = NX1D_ENGINE_FILTER;
+                break;
+            case 'n':
+                n_values = atoi(optarg);
+                if(n_values < 1){
+                    fprintf(stderr, "\n(-) ERROR: the number of value columns has to be positive\n    Aborting...\n\n");
+                    exit(1);
+                }
+                break;
+            case 'd':
+                derivatives = atoi(optarg);
+                if(derivatives < 0 || derivatives > 2){
+                    fprintf(stderr, "\n(-) ERROR: the derivative order has to be 0, 1 or 2\n    Aborting...\n\n");
+                    exit(1);
+                }
+                break;
+            case 'B':
+                batchfile = optarg;
+                break;
+            case 'P':
+                if(strcmp(optarg, "double") == 0){
+                    precision = NX1D_PRECISION_DOUBLE;
+                }else if(strcmp(optarg, "float") == 0){
+                    precision = NX1D_PRECISION_FLOAT;
+                }else if(strcmp(optarg, "mixed") == 0){
+                    precision = NX1D_PRECISION_MIXED;
+                }else{
+                    fprintf(stderr, "\n(-) ERROR: unknown precision \"%s\"\n    Aborting...\n\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'H':
+                if(strcmp(optarg, "thp") == 0){
+                    pages = NX1D_PAGES_DEFAULT;
+                }else if(strcmp(optarg, "small") == 0){
+                    pages = NX1D_PAGES_SMALL;
+                }else if(strcmp(optarg, "huge") == 0){
+                    pages = NX1D_PAGES_HUGE;
+                }else{
+                    fprintf(stderr, "\n(-) ERROR: unknown page mode \"%s\"\n    Aborting...\n\n", optarg);
+                    exit(1);
+                }
+                break;
+            case 'q':
+                pipelined = 1;
+                break;
+            case 's':
+                memory = (size_t)atol(optarg) << 20;
+                break;
+            case 'O':
+                order_list = optarg;
+                break;
+            case 'p':
+                pointfile = optarg;
+                break;
+            case 'U':
+                previousfile = optarg;
+                break;
+            case 'R':
+                profile_format = optarg;
+                break;
+            case 'o':
+                outputfile = optarg;
+                break;
+            default:
+                PrintUsage(argv[0]);
+                exit(1);
+        }
+    }
+
+// Positional arguments: inputfile [dimension] [n_spline],
+//  the batch file replaces the inputfile
+    if(batchfile == NULL){
+        if(optind >= argc){
+            PrintUsage(argv[0]);
+            exit(1);
+        }
+        inputfile = argv[optind++];
     }
-    if(argc > 3){
-        n_spline = atoi(argv[3]);
+    if(argc > optind){
+        dimension = atoi(argv[optind]);
     }
+    if(argc > optind + 1){
+        n_spline = atoi(argv[optind + 1]);
+    }
+    binary_in  = IsBinaryFile(inputfile);
+    binary_out = binary_out || IsBinaryFile(outputfile);
 
-// Memory allocation
-    nq = calloc(dimension, sizeof(int));
-    v  = malloc(sizeof(double));
-    q  = malloc(sizeof(double*));
-    for(i = 0; i < dimension; ++i){
-        q[i] = malloc(sizeof(double));
+// profiling is enabled by -R or the environment variable NX1D_PROFILE
+#ifdef NX1D_PROFILE
+    profile = ProfileEnable(profile_format != NULL ? profile_format : getenv("NX1D_PROFILE"));
+#else
+    if(profile_format != NULL){
+        fprintf(stderr, "\n(*) Warning: -R is ignored, profiling requires a build with -DNX1D_PROFILE\n");
     }
+#endif
 
-// Actual input
-    n_points = InputFunction(inputfile, &q, nq, &v, dimension);
+// pipelined output is a mode of the dense double interpolation only
+    if(pipelined && (batchfile != NULL || memory > 0 || pointfile != NULL || previousfile != NULL
+    || precision != NX1D_PRECISION_DOUBLE)){
+        fprintf(stderr, "\n(-) ERROR: -q can't be combined with -B, -P, -s, -p or -U\n    Aborting...\n\n");
+        exit(1);
+    }
+
+// derivative output is a mode of the dense interpolation only
+    if(derivatives > 0 && (batchfile != NULL || memory > 0 || pointfile != NULL || previousfile != NULL)){
+        fprintf(stderr, "\n(-) ERROR: -d can't be combined with -B, -s, -p or -U\n    Aborting...\n\n");
+        exit(1);
+    }
+
+// batch mode, every surface is read from and written to its own file
+    if(batchfile != NULL){
+        if(memory > 0 || pointfile != NULL || outputfile != NULL || previousfile != NULL || n_values > 1
+        || precision != NX1D_PRECISION_DOUBLE){
+            fprintf(stderr, "\n(-) ERROR: -B can't be combined with -n, -P, -s, -p, -U or -o\n    Aborting...\n\n");
+            exit(1);
+        }
+        nx1dBatchInterpolation(batchfile, dimension, n_spline, n_threads, engine, order_list,
+                               binary_out, text_flags);
+        return 0;
+    }
+
+// incremental update, the input file lists the changed points
+    if(previousfile != NULL){
+        if(memory > 0 || pointfile != NULL || precision != NX1D_PRECISION_DOUBLE){
+            fprintf(stderr, "\n(-) ERROR: -U can't be combined with -P, -s or -p\n    Aborting...\n\n");
+            exit(1);
+        }
+        nx1dUpdateInterpolation(previousfile, inputfile, dimension, n_spline, n_values, n_threads, engine,
+                                order_list, outputfile, binary_out, text_flags);
+        return 0;
+    }
+
+// Memory allocation, the coordinate and potential arrays
+//  are allocated by InputFunction
+    nq     = calloc(dimension, sizeof(int));
+    nq_new = calloc(dimension, sizeof(int));
+    origin = calloc(dimension, sizeof(double));
+    q      = calloc(dimension, sizeof(double*));
+    if(nq == NULL || nq_new == NULL || origin == NULL || q == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "grid arrays");
+        exit(2);
+    }
+
+// Actual input, binary grids carry nq, origin and dq in their header,
+//  the potential array is directly mapped from the file
+#ifdef NX1D_PROFILE
+    start = ProfileTime();
+#endif
+    if(binary_in){
+        n_points = BinaryInputFunction(inputfile, &map, nq, origin, &dq, &n_spline_in, &n_values, &v, dimension);
+    }else{
+        n_points = InputFunction(inputfile, &q, nq, &v, dimension, n_values);
+    }
+#ifdef NX1D_PROFILE
+    ProfileStage("input", start, inputfile);
+#endif
 
 // check input
     for(i = 0, k = 1; i < dimension; ++i){
@@ -46,61 +378,205 @@ int main(int argc, char **argv){
     }
     if(k != n_points){
         fprintf(stderr, "\n (-) Error in input file:"
-                        "\n     Product of dimension lengths (%d) does not match n_points (%d)"
+                        "\n     Product of dimension lengths (%zu) does not match n_points (%zu)"
                         "\n     Aborting...\n\n"
                         , k, n_points
                );
         exit(1);
     }
 
-// calculate dq, assume equi distant spacing
-    dq = q[dimension-1][1] - q[dimension-1][0];
+// calculate dq, assume equi distant spacing,
+//  the origin is given by the coordinates of the first point
+    if(!binary_in){
+        dq = q[dimension-1][1] - q[dimension-1][0];
+        for(i = 0; i < dimension; ++i){
+            origin[i] = q[i][0];
+        }
+    }
 
+// the coordinates are not needed anymore, the output derives them
+//  from origin and dq
+    for(i = 0; i < dimension; ++i){
+        free(q[i]); q[i] = NULL;
+    }
+
+// out-of-core interpolation streams the result directly into the output file
+    if(memory > 0){
+        if(n_values > 1){
+            fprintf(stderr, "\n(-) ERROR: out-of-core interpolation (-s) requires a single value per point\n    Aborting...\n\n");
+            exit(1);
+        }
+#ifdef NX1D_PROFILE
+        start = ProfileTime();
+#endif
+        nx1dStreamInterpolation(v, nq, origin, dq, dimension, n_spline, n_threads, engine, memory, outputfile);
+#ifdef NX1D_PROFILE
+        ProfileStage("stream", start, outputfile);
+#endif
+        if(binary_in){
+            BinaryInputRelease(&map);
+        }else{
+            free(v);
+        }
+        return 0;
+    }
 
 // start interpolation process
-    n_points = nx1dInterpolation(&v, nq, dq, dimension, n_spline);
+#ifdef NX1D_PROFILE
+    start = ProfileTime();
+#endif
+    CheckPlanError(nx1dPlanCreate(&plan, nq, dq, dimension, n_spline, n_values));
+    SetupPlan(plan, dimension, n_threads, engine, order_list);
+    CheckPlanError(nx1dPlanSetPages(plan, pages));
+    CheckPlanError(nx1dPlanSetDerivatives(plan, derivatives));
+#ifdef NX1D_PROFILE
+    CheckPlanError(nx1dPlanSetProfile(plan, profile));
+    ProfileStage("plan", start, NULL);
+#endif
 
-// calculate new dq
-    dq = dq / (double)(n_spline + 1);
+// every interpolated point carries the values and their derivatives
+    n_out = n_values * (1 + derivatives * dimension);
 
-// reallocate memory for all q[*]s
-    for(i = 0; i < dimension; ++i){
-        q[i] = realloc(q[i], n_points * sizeof(double));
+// scattered points: the spline coefficients are computed once and
+//  evaluated at the requested points only
+    if(pointfile != NULL){
+#ifdef NX1D_PROFILE
+        start = ProfileTime();
+#endif
+        n_points = PointInputFunction(pointfile, &x, dimension);
+        yy = malloc((n_points > 0 ? (size_t)n_points * n_values : 1) * sizeof(double));
+        if(yy == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "interpolated data");
+            exit(2);
+        }
+#ifdef NX1D_PROFILE
+        ProfileStage("points", start, pointfile);
+        start = ProfileTime();
+#endif
+        CheckPlanError(nx1dSplineCreate(&spline, plan, v, origin));
+#ifdef NX1D_PROFILE
+        ProfileStage("spline", start, NULL);
+        start = ProfileTime();
+#endif
+        CheckPlanError(nx1dSplineEvaluate(spline, x, n_points, yy));
+#ifdef NX1D_PROFILE
+        ProfileStage("evaluate", start, NULL);
+        start = ProfileTime();
+#endif
+        PointOutputFunction(outputfile, x, yy, n_points, dimension, n_values);
+#ifdef NX1D_PROFILE
+        ProfileStage("output", start, outputfile != NULL ? outputfile : "-");
+#endif
+
+        nx1dSplineDestroy(spline);
+        nx1dPlanDestroy(plan);
+        return 0;
     }
 
-// fill all q[*]s
-    for(i = dimension-1, jump = 1; i >= 0; --i){
+// float precision modes: the input is converted to float, the result is
+//  converted back to double block by block on output
+    if(precision != NX1D_PRECISION_DOUBLE){
+        CheckPlanError(nx1dPlanSetPrecision(plan, precision));
+        vf = malloc(n_points * n_values * sizeof(float));
+        yf = nx1dPlanAlloc(plan, nx1dPlanPoints(plan, NULL) * n_out * sizeof(float));
+        if(vf == NULL || yf == NULL){
+            fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "interpolated data");
+            exit(2);
+        }
+        for(j = 0; j < n_points * n_values; ++j){
+            vf[j] = v[j];
+        }
+        if(binary_in){
+            BinaryInputRelease(&map);
+        }else{
+            free(v);
+        }
 
-        for(j = 0; j < n_points/jump/nq[i]; ++j){
-            for(k = 0; k < nq[i]; ++k){
-                for(l = 0; l < jump; ++l){
+#ifdef NX1D_PROFILE
+        start = ProfileTime();
+#endif
+        CheckPlanError(nx1dPlanExecuteFloat(plan, vf, yf));
+#ifdef NX1D_PROFILE
+        ProfileStage("execute", start, NULL);
+        ProfilePlan(plan, dimension);
+#endif
+        free(vf);
+        n_points = nx1dPlanPoints(plan, nq_new);
+        nx1dPlanDestroy(plan);
 
-                    q[i][l + k*jump + j*nq[i]*jump] = q[i][0] + (double)k * dq;
+#ifdef NX1D_PROFILE
+        start = ProfileTime();
+#endif
+        FloatOutput(outputfile, binary_out, text_flags, nq_new, origin, dq / (double)(n_spline + 1),
+                    n_spline, yf, n_points, dimension, n_out);
+#ifdef NX1D_PROFILE
+        ProfileStage("output", start, outputfile != NULL ? outputfile : "-");
+#endif
+        nx1dFree(yf);
+        return 0;
+    }
 
-                }
-            }
+// pipelined output, the result is written while it is computed
+    if(pipelined){
+#ifdef NX1D_PROFILE
+        start = ProfileTime();
+#endif
+        nx1dPipelinedInterpolation(plan, v, order_list, origin, dq / (double)(n_spline + 1), n_spline,
+                                   dimension, n_out, outputfile, binary_out, text_flags);
+#ifdef NX1D_PROFILE
+        ProfileStage("pipeline", start, outputfile != NULL ? outputfile : "-");
+        ProfilePlan(plan, dimension);
+#endif
+        nx1dPlanDestroy(plan);
+        if(binary_in){
+            BinaryInputRelease(&map);
+        }else{
+            free(v);
         }
-        jump *= nq[i];
+        return 0;
     }
 
+    yy = nx1dPlanAlloc(plan, nx1dPlanPoints(plan, NULL) * n_out * sizeof(double));
+    if(yy == NULL){
+        fprintf(stderr, "\n(-) ERROR in memory allocation of %s\n    Aborting...\n\n", "interpolated data");
+        exit(2);
+    }
+// text input is freed as soon as the first dimension is done
+#ifdef NX1D_PROFILE
+    start = ProfileTime();
+#endif
+    if(binary_in){
+        CheckPlanError(nx1dPlanExecute(plan, v, yy));
+        BinaryInputRelease(&map);
+    }else{
+        CheckPlanError(nx1dPlanExecuteConsume(plan, v, yy));
+    }
+#ifdef NX1D_PROFILE
+    ProfileStage("execute", start, NULL);
+    ProfilePlan(plan, dimension);
+#endif
+    n_points = nx1dPlanPoints(plan, nq_new);
 
-// output
-    printf("N");
-    for(i = 0; i < dimension; ++i){ printf("\t% d", nq[i]); } printf("\n");
+    nx1dPlanDestroy(plan);
+    v = yy;
 
-    for(i = 0, j = 0; i < n_points; ++i){
-    // add blank lines
-        for(j = (dimension-1), k = 1; j >= 0; --j){
-            k *= nq[j];
-            if(i%k == 0){ printf("\n"); }
-        }
-    // actual output
-        for(j = 0; j < dimension; ++j){
-            printf("\t% 16.12lf", q[j][i]);
-        }
-        printf("\t% 16.12lf", v[i]);
-        printf("\n");
+// calculate new dq
+    dq = dq / (double)(n_spline + 1);
+
+// binary output is written directly from the interpolated array
+#ifdef NX1D_PROFILE
+    start = ProfileTime();
+#endif
+    if(binary_out){
+        BinaryOutputFunction(outputfile, nq_new, origin, dq, n_spline, v, dimension, n_out);
+    }else{
+        writer = TextOutputOpen(outputfile, nq_new, origin, dq, dimension, n_out, text_flags);
+        TextOutputWrite(writer, v, n_points);
+        TextOutputClose(writer);
     }
+#ifdef NX1D_PROFILE
+    ProfileStage("output", start, outputfile != NULL ? outputfile : "-");
+#endif
 
     return 0;
 }
@@ -0,0 +1,85 @@
+#ifndef NX1D_IO_H
+#define NX1D_IO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "nx1dInterpolator.h"
+
+// Memory mapping of a binary grid file (see BinaryIO.c)
+typedef struct BinaryMap {
+    void * base;            // start of the mapping or of the allocated copy
+    size_t size;            // size of the mapping in bytes
+    int    mapped;          // 1 if base has to be unmapped, 0 if it has to be freed
+} BinaryMap;
+
+// Text input
+size_t InputFunction(char *inputfile, double ***q, int *nq, double **V, int dimension, int n_values);
+int PointInputFunction(char *inputfile, double **x, int dimension);
+
+// Buffered text output (see OutputFunction.c)
+#define TEXT_NO_COORDINATES 0x1     // write values only
+
+typedef struct TextWriter TextWriter;
+
+TextWriter * TextOutputOpen(char *outputfile, const int *nq, const double *origin, double dq,
+                            int dimension, int n_values, int flags);
+void         TextOutputWrite(TextWriter *w, const double *v, size_t n);
+int          TextOutputClose(TextWriter *w);
+int          PointOutputFunction(char *outputfile, const double *x, const double *V, int n, int dimension,
+                                 int n_values);
+
+// Binary input and output
+size_t BinaryInputFunction(char *inputfile, BinaryMap *map, int *nq, double *origin, double *dq,
+                           int *n_spline, int *n_values, double **V, int dimension);
+void BinaryInputRelease(BinaryMap *map);
+double * BinaryMapWritable(char *file, BinaryMap *map, size_t n_entries, int dimension);
+size_t BinaryOutputFunction(char *outputfile, const int *nq, const double *origin, double dq,
+                            int n_spline, const double *V, int dimension, int n_values);
+int  BinaryOutputOpen(char *outputfile, const int *nq, const double *origin, double dq,
+                      int n_spline, int dimension, int n_values);
+int  BinaryOutputBlock(int fd, const double *V, size_t n, off_t offset);
+void BinaryOutputClose(int fd, char *outputfile, int failed);
+size_t BinaryHeaderSize(int dimension);
+int  IsBinaryFile(const char *filename);
+
+// Out-of-core interpolation into a binary grid file, using about
+//  <memory> bytes (see StreamInterpolation.c)
+size_t nx1dStreamInterpolation(const double *v, const int *nq, const double *origin, double dq,
+                               int dimension, int n_spline, int n_threads, int engine, size_t memory,
+                               char *outputfile);
+
+// Interpolation by plan whose output is written by a writer thread while
+//  it is computed (see Pipeline.c)
+size_t nx1dPipelinedInterpolation(nx1dPlan *plan, const double *v, char *order_list, const double *origin,
+                                  double dq, int n_spline, int dimension, int n_values, char *outputfile,
+                                  int binary_out, int text_flags);
+
+// Interpolation of a batch of single valued surfaces on the same grid,
+//  listed as "inputfile outputfile" pairs in batchfile (see Batch.c)
+int nx1dBatchInterpolation(char *batchfile, int dimension, int n_spline, int n_threads, int engine,
+                           char *order_list, int binary_out, int text_flags);
+
+// Correct the previous result previousfile for the changed input points
+//  listed in deltafile (see Update.c)
+int nx1dUpdateInterpolation(char *previousfile, char *deltafile, int dimension, int n_spline, int n_values,
+                            int n_threads, int engine, char *order_list, char *outputfile,
+                            int binary_out, int text_flags);
+
+// Abort on an error code of the interpolation library and apply the
+//  command line settings to a plan (see main.c)
+void CheckPlanError(int error);
+void SetupPlan(nx1dPlan *plan, int dimension, int n_threads, int engine, char *order_list);
+
+// Stage profiling, compiled with -DNX1D_PROFILE only (see Profile.c)
+#ifdef NX1D_PROFILE
+#define PROFILE_TABLE 1             // summary table on stderr
+#define PROFILE_JSON  2             // JSON document on stderr
+
+int    ProfileEnable(const char *format);
+double ProfileTime(void);
+void   ProfileStage(const char *name, double start, const char *file);
+void   ProfilePlan(const nx1dPlan *plan, int dimension);
+#endif
+
+#endif
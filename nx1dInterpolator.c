@@ -1,11 +1,20 @@
-
-#include <stdio.h>
 #include <stdlib.h>
-
-// provided prototypes
-int nx1dInterpolation(double** v, int* nq_in, double dq, int dimension, int n_spline);
-
-int nx1dInterpolation(double** v, int* nq_in, double dq, int dimension, int n_spline){
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+#ifdef NX1D_PROFILE
+    #include <unistd.h>
+    #include <sys/syscall.h>
+    #include <linux/perf_event.h>
+#endif
+
+#include "nx1dInterpolator.h"
 
 /*  One dimensional cubic spline interpolation:
 //{{{
@@ -109,76 +118,1638 @@ int nx1dInterpolation(double** v, int* nq_in, double dq, int dimension, int n_sp
        d'_{n} = (d_{n} - d'_{n-1}) / (4 - c'_{n-1})
 //*/
 
-//----------------------------------------------------------------------
-//  Declaration   Declaration   Declaration   Declaration   Declaration
-//----------------------------------------------------------------------
-// For better readability the parameters of the Thomas algorithm will
-//  be prefixed with "matrix_" and the interpolation parameters will
-//  be prefixed with "inter_"
-
-    int i, j, k, l, m;
-    int maxdim    = 0;
-    int n_points  = 0;
-    int nn_points = 0;
-    double newdq  = 0;
-
-// nq array containing number of points per dimension
-//  the new nq array is needed to prevent overwriting of the original
-//  value in the superordinate function stack
-    int * nq = NULL;            // freed
-
-// tridiagonal matrix algorithm coefficients
-    double * matrix_c = NULL;   // freed
-    double * matrix_d = NULL;   // freed
-// interpolation coefficients
-    double * inter_c  = NULL;   // freed
-    double   inter_b;
-    double   inter_d;
-// interpolated data array
-    double * yy = NULL;         // freed
-
-// auxiliary pointers to allow freeing and swapping
-    double * aux_v  = (*v);     // freed
-    double * aux_yy = NULL;     // at the end points to new *v => don't free!!!
+/*  Recursive filter engine:
+//{{{
+    The (1,4,1) matrix factorizes into a causal and an anti-causal first
+    order filter with the pole kappa = 2 - sqrt(3)
 
-// variables for dimensional loop
-//  to break down n-dimensional arrays to a set of 1D arrays
-    int n_iteration;      // Number of 1D runs over ND array
-    int jump;             // Index difference between the nth and (n+1)th entry for a given dimension
-    int d_jump;           // The number of jumps because of superordinate dimensions
-    int offset = 0;       // Offset added after each <d_jump> position, corresponds to previous jump
-    int inter_offset = 0; // Offset on new interpolated array
-
-
-//----------------------------------------------------------------------
-//  Initialisation   Initialisation   Initialisation   Initialisation
-//----------------------------------------------------------------------
-// determine the size of the dimension with the most entries
-//  and calculate n_points
-    for(i = 0, maxdim = 1, n_points = 1, nn_points = 1; i < dimension; ++i){
-        if(nq_in[i] > maxdim){
-            maxdim = nq_in[i];
-        }
-        n_points  *= nq_in[i];
-        nn_points *= ((nq_in[i] - 1) * (n_spline + 1) + 1);
-    }
-
-// allocate memory for matrix_c, matrix_d and inter_c arrays
-//  as well as the new array containing interpolated data yy
-    matrix_c = malloc((maxdim-1) * sizeof(double)); // freed
-    matrix_d = malloc((maxdim-1) * sizeof(double)); // freed
-    inter_c  = malloc((maxdim-1) * sizeof(double)); // freed
-    yy       = malloc(nn_points  * sizeof(double)); // freed
-    aux_yy   = malloc(nn_points  * sizeof(double)); // points to new *v (old is freed by freeing aux_v)
-
-//  allocate memory for nq and fill it with nq_in values
-    nq = malloc(dimension * sizeof(int));
+        1 + 4 z + z^2 = (1 + kappa z)(1 + kappa/z) z / kappa
+
+    The system above is the infinite one restricted by the boundaries
+    c_{-1} = 0 (row 0 is 4 c_0 + c_1 = d'_0 = 0) and c_{n-1} = 0. Extending
+    d antisymmetrically about both boundary points gives an infinite system
+    whose solution is antisymmetric as well, i.e. vanishes at -1 and n-1 and
+    solves the finite system. Its causal part w and the coefficients c are
+
+        w_i = kappa (d_i - w_{i-1})                         (causal)
+        c_i = w_i - kappa c_{i+1},      c_{n-1} = 0         (anti-causal)
+
+    The anti-causal filter starts exactly at the natural boundary, the causal
+    filter starts from the sum over the reflected d of the left boundary
+
+        w_0 = kappa d_0 - kappa^3  sum_{j>=0} (-kappa)^j d_j
+
+    which the filter engine (NX1D_ENGINE_FILTER) truncates after the term
+    j = NX1D_FILTER_TERMS (plan->filter_init holds its factors). Both sweeps
+    then are fixed multiply-add recurrences without the c' table. The
+    truncation is the only approximation, its error decays along the line:
+
+        |c_i - c_i(Thomas)| <= kappa^(K+4+i) / ((1-kappa)(1-kappa^2)) max|d_j|
+
+    which is below 1e-18 max|d_j| for K = NX1D_FILTER_TERMS = 28, i.e. far
+    below the rounding of either engine; the interpolated values of both
+    engines agree to a few ulp. Lines of at most K+1 points, whose sum would
+    reach the right boundary, are solved by the Thomas algorithm. The chunks
+    of a long line (see "Long lines") have the same boundaries, with d_0 of
+    a chunk being the regular row of the line.
+//}}}*/
+
+/* Lane parallel solution of neighbouring 1D splines:
+//{{{
+    For every dimension k the 1D lines of the ND array are addressed as
+
+        index = m + i*jump + l*offset       m ∊ [0,jump[, i ∊ [0,nq[k][
+
+    Lines with neighbouring m are therefore adjacent in memory, i.e. the i-th
+    entries of NX1D_LANES consecutive lines form one contiguous block. Since
+    the tridiagonal matrix is identical for all lines, these lines are solved
+    simultaneously with each line occupying one lane of a SIMD vector. This
+    turns the strided gathers of a single line into contiguous vector loads
+    and interleaves NX1D_LANES independent Thomas dependency chains.
+
+    The lane count follows the instruction set the compiler targets
+    (AVX-512: 8, AVX/AVX2: 4, SSE2: 2, otherwise scalar). If less than
+    NX1D_LANES lines are left at the end of a row the unused lanes are
+    zero padded, so every line is processed by the very same code.
+//}}}*/
+#if   defined(__AVX512F__)
+    #define NX1D_LANES 8
+#elif defined(__AVX__)
+    #define NX1D_LANES 4
+#elif defined(__SSE2__)
+    #define NX1D_LANES 2
+#else
+    #define NX1D_LANES 1
+#endif
+
+
+typedef double vdouble __attribute__ ((vector_size (NX1D_LANES * sizeof(double))));
+
+// vectors of the float precision modes (see "Precision modes"): vfloat has
+//  the size of a vdouble and twice its lanes, vmixed is the float storage
+//  of the lanes of a vdouble
+#define NX1D_FLOAT_LANES (2 * NX1D_LANES)
+typedef float vfloat __attribute__ ((vector_size (NX1D_LANES * sizeof(double))));
+typedef float vmixed __attribute__ ((vector_size (NX1D_LANES * sizeof(float))));
+
+// page size assumed by the pass cost model and the maximum number of
+//  dimensions for which the pass order is optimized
+#define NX1D_PAGE_SIZE      4096
+#define NX1D_MAX_ORDER_DIM  16
+
+// number of intervals sharing the basis matrix rows kept in registers
+#define NX1D_EVAL_BLOCK     4
+
+// number of terms of the start value of the recursive filter engine
+//  (see "Recursive filter engine")
+#define NX1D_FILTER_TERMS   28
+
+// minimum number of unknowns per chunk of a long line and number of
+//  entries of the chunk response spike (see "Long lines")
+#define NX1D_MIN_CHUNK      1024
+#define NX1D_SPIKE_LENGTH   48
+
+// number of perf_event counters per thread of a profiled plan (see "Profiling")
+#define NX1D_N_COUNTERS     4
+
+// maximum number of dimensions of scattered point evaluation
+//  (the coefficient tensor holds 2^dimension arrays)
+#define NX1D_MAX_SPLINE_DIM 10
+
+// size of the tiles of strided passes (per thread) and the maximum
+//  number of lines per tile (see "Tiled passes")
+#define NX1D_TILE_BYTES     (1 << 20)
+#define NX1D_MAX_TILE_WIDTH 128
+
+// magnitude below which the line response of an update is cut off
+//  (see "Incremental update")
+#define NX1D_UPDATE_CUTOFF  1.0e-20
+
+// huge page size, minimum size of a mapped grid and size of the block
+//  header in front of every grid of nx1dPlanAlloc() (see "Grid memory")
+#define NX1D_HUGE_PAGE_SIZE (2 << 20)
+#define NX1D_MAP_THRESHOLD  (4 << 20)
+#define NX1D_BLOCK_HEADER   64
+
+/*  Interpolation plan:
+//{{{
+    The c'_i recursion of the forward sweep neither depends on the data nor on
+    the length n of the line (apart from where it ends), hence one table
+
+        c'_{0} = 1/4,   c'_{i} = 1 / (4 - c'_{i-1})
+
+    of maxdim-1 entries serves every line of every dimension. Note that the last
+    row of a line of length n uses 1/(4 - c'_{n-3}) = c'_{n-2}, i.e. it is the
+    next element of the very same table. Together with the constant factors
+    3/dq^2, 1/dq, 1/(3 dq) and dq/3 and the basis matrix (vide infra) of the
+    n_spline+2 interpolation positions t_j = j*newdq within one interval, the
+    forward sweep, back substitution and evaluation are free of divisions.
+    All of these as well as the scratch space are stored in the plan.
+
+    The lines of one dimension are independent of each other and are
+    distributed over n_threads OpenMP threads, each of which owns a private
+    block of scratch vectors (matrix_d/inter_b, inter_c, inter_d and line of
+    maxdim entries, padded to full cache lines). The end of every pass acts as barrier,
+    since pass p+1 reads the data written by pass p.
+
+    The intermediate grid after pass p is interpolated along the dimensions
+    order[0..p] only. Even passes write to yy, odd ones to aux_yy and the last
+    one directly to the output array, so each of the two buffers is only as
+    large as the largest intermediate grid it ever holds. Since every entry
+    of an intermediate grid is written before it is read, the buffers are
+    never initialized.
+//}}}*/
+
+/*  Basis matrix evaluation:
+//{{{
+    The interpolation positions t_j are the same for every interval, line and
+    dimension, hence evaluating the polynomials of all intervals of a line is
+    the product of the (n_spline+2) x 4 basis matrix
+
+        B_j = ( 1   t_j   t_j^2   t_j^3 )
+
+    with the 4 x (n-1) matrix of interval coefficients (a_i b_i c_i d_i)^T,
+    where every entry is a vector of NX1D_LANES lines. The back substitution
+    therefore first stores the coefficients of all intervals, and
+    nx1dEvaluate then applies B to blocks of NX1D_EVAL_BLOCK intervals at a
+    time: the four entries of B_j are kept in registers for the whole block
+    and the products of different intervals are independent of each other,
+    instead of being interleaved with the serial recursion of the back
+    substitution. The last row (t = dq) is only evaluated for the end point
+    of the last interval.
+
+    A single contiguous line (jump = 1, i.e. the pass over the last dimension
+    of a single valued grid) only fills one lane of each vector. Since its
+    n_spline+1 values of one interval are neighbours in memory, nx1dEvaluateLine
+    vectorizes over the positions j instead: the scalar coefficients of an
+    interval are applied to NX1D_LANES rows of the column-major copy basis_t
+    of the basis matrix at a time.
+//}}}*/
+
+/*  Pass order:
+//{{{
+    The tensor product interpolation gives the same result (up to rounding)
+    for every order of the dimensional passes, but not at the same cost: a
+    pass runs over an intermediate grid that has grown by about n_spline+1
+    along every dimension interpolated before, and its lines are only
+    vectorized over neighbouring entries, i.e. a pass over the last dimension
+    (jump = n_values) fills a single lane of each vector.
+
+    The cost of a pass is estimated as the number of vectors nx1dSolveLines
+    loads and stores, doubled if consecutive entries of a line lie on
+    different pages (where neither the prefetcher nor the TLB help anymore).
+    Since the cost of a pass only depends on which dimensions have already
+    been interpolated, the cheapest order is found by dynamic programming over
+    the subsets of dimensions instead of trying all dimension! permutations.
+    The memory layout of the output does not depend on the order.
+//}}}*/
+
+/*  Tiled passes:
+//{{{
+    If the entries of a line are a page or more apart (jump*8 >= NX1D_PAGE_SIZE)
+    every vector a pass loads or stores lies on a different page, the hardware
+    prefetcher never gets going and the TLB is thrashed. Such passes process
+    the lines in tiles of tile_width neighbouring lines instead: the n entries
+    of all lines of a tile are gathered row by row (tile_width contiguous
+    doubles each) into a private scratch tile, solved there with the tile
+    width as jump, and the interpolated rows are scattered back in the same
+    way. Both copies stream whole cache lines and touch each page once per
+    tile instead of once per group of NX1D_LANES lines. The tile width is
+    chosen such that input and output tile of the longest dimension fit into
+    NX1D_TILE_BYTES.
+//}}}*/
+
+/*  Long lines:
+//{{{
+    If a pass has too few lines, distributing whole lines leaves lanes or
+    threads idle; for a 1D grid the single Thomas recursion runs on one lane
+    of one core. Contiguous lines (jump = 1) occupy one lane each, strided
+    lines share the lanes of a group, hence a pass is split if it has less
+    than n_threads*NX1D_LANES contiguous lines or less than n_threads groups
+    of strided lines. The unknowns of such lines are split into
+    n_chunks chunks of at least NX1D_MIN_CHUNK entries (up to one chunk per
+    lane and thread). With the neighbouring values c_{s-1} and c_e of a chunk
+    [s,e) moved to the right hand side, the chunk is a (1,4,1) system T of
+    its own and its solution is
+
+        c = y + c_{s-1} u + c_e w,      T y = r,  T u = -e_first,  T w = -e_last
+
+    Since T is the same constant Toeplitz matrix for every chunk, w is u
+    reversed and u_i decays like (-kappa)^(i+1) with kappa = 2-sqrt(3). After
+    NX1D_SPIKE_LENGTH entries |u_i| < 1e-27, and at the far end of a chunk of
+    NX1D_MIN_CHUNK entries u underflows to zero. Only the first entries of u
+    (the spike) are stored, and the two values at a chunk boundary only
+    depend on each other:
+
+        c_{s-1} = y_{s-1} + u_0 c_s,    c_s = y_s + u_0 c_{s-1}
+
+    nx1dSolveLong therefore
+        1. solves for y of all chunks, NX1D_LANES chunks per vector and the
+           groups of chunks in parallel (nx1dSolveChunks),
+        2. solves the 2x2 system of every chunk boundary,
+        3. adds the spikes scaled by the boundary values to both ends of
+           every chunk and
+        4. evaluates the intervals of every chunk,
+    with a barrier after each step. The result agrees with the serial
+    recursion up to rounding.
+//}}}*/
+/*  Scattered points:
+//{{{
+    In terms of the values a_i, a_{i+1} and the coefficients c_i, c_{i+1}
+    the polynomial of interval i of a line reads (t ∊ [0,h], h = dq)
+
+        f(t) = (1 - t/h) a_i + t/h a_{i+1}
+             + (t^2 - 2/3 h t - t^3/(3h)) c_i + (t^3/(3h) - h t/3) c_{i+1}
+             = A(t) a_i + B(t) a_{i+1} + C(t) c_i + D(t) c_{i+1}
+
+    Every pass is linear, hence the n-dimensional interpolant is the tensor
+    product of these 1D forms. nx1dSplineCreate() computes for every subset
+    S of the dimensions the array G_S obtained by replacing the values along
+    the dimensions in S by their coefficients c, i.e. G_{} is the data, G_{k}
+    holds the c of the lines of dimension k, G_{k,j} the c along j of G_{k}
+    and so on. The 2^d arrays are stored interleaved, so the 2^d n_values
+    entries of a grid point are contiguous (2^d times the input memory).
+
+    A point x in the cell with lower corner i evaluates to
+
+        f(x) = sum_e sum_S  prod_k w_k(e_k, S_k)  G_S[i + e]
+
+    with the corner offsets e ∊ {0,1}^d and w_k(0,0) = A(t_k),
+    w_k(1,0) = B(t_k), w_k(0,1) = C(t_k), w_k(1,1) = D(t_k). These are 4^d
+    terms, evaluated as 2^d dot products of a weight vector and a contiguous
+    block of coefficients; the points of a batch are distributed over the
+    threads. Points outside of the grid are extrapolated by the polynomial of
+    the nearest interval. On the points of the interpolated grid the result
+    agrees with nx1dPlanExecute() up to rounding.
+//}}}*/
+
+/*  Precision modes:
+//{{{
+    The passes are memory bound: every pass streams its input and output grid
+    once, and the intermediate grids of a large problem do not fit into any
+    cache. Storing the grids as float halves this traffic. Two float modes
+    are provided next to the default double mode (nx1dPlanSetPrecision):
+
+        NX1D_PRECISION_FLOAT    float storage and float arithmetic, vfloat
+                                vectors solve 2*NX1D_LANES lines at once
+        NX1D_PRECISION_MIXED    float storage, the lines are converted to
+                                vdouble on load and solved in double
+
+    The kernels of all modes are the same code (nx1dKernel.h), instantiated
+    once per mode with the storage and arithmetic types. Since a vfloat has
+    the size of a vdouble, scratch space, tiles and chunks are shared by all
+    modes; only the intermediate grids shrink. Single precision rounding
+    (2^-24, i.e. about 6e-8 relative) is far below the interpolation error
+    of a typical grid, and the (1,4,1) recursion is stable (its factors c'_i
+    are bounded by 2-sqrt(3)), so float errors do not grow along a line.
+    Mixed mode only rounds the stored values and keeps the solve at double
+    precision. Scattered point evaluation always works in double.
+//}}}*/
+
+/*  Profiling:
+//{{{
+    Every execution records wall time, solved lines and grid bytes of each
+    pass (nx1dPlanPassStats). With -DNX1D_PROFILE a profiled plan
+    (nx1dPlanSetProfile) additionally opens NX1D_N_COUNTERS perf_event
+    counters per thread, each thread for itself inside a parallel region of
+    the plan's size (the OpenMP runtime keeps the threads of a team size),
+    and sums the counter differences of all threads around every pass:
+
+        task clock          CPU time of the threads (software counter)
+        cycles              CPU cycles in user space
+        instructions        retired instructions in user space
+        cache misses        last level cache misses in user space
+
+    Counters the kernel or the machine does not provide (e.g. hardware
+    counters in a virtual machine or with perf_event_paranoid > 2) are
+    reported as -1. Without -DNX1D_PROFILE none of this is compiled in.
+//}}}*/
+
+/*  Incremental update:
+//{{{
+    Every pass is linear, so changing the input by a sparse delta changes the
+    result by the interpolation of the delta alone. The delta of a single
+    grid point i with the change d is the product of unit vectors e_{i_k}
+    along the dimensions, and so is its interpolation:
+
+        out[j] += d  prod_k  R_k[j_k, i_k]
+
+    where the column R_k[., i_k] is the 1D interpolation of e_{i_k} along
+    dimension k. nx1dPlanUpdate() obtains the columns of all changed points
+    at once from a 1D plan with one value per change, i.e. by the same line
+    solver as nx1dPlanExecute(), and adds the products to a previous result.
+
+    Although the natural spline couples the whole line, the response of a
+    unit vector decays by the pole 2-sqrt(3) per grid point. Entries below
+    NX1D_UPDATE_CUTOFF are dropped, which restricts every change to a box of
+    about 2*35*(n_spline+1) points per dimension; the dropped terms are far
+    below the rounding of the result. The update therefore agrees with a full
+    execution on the changed input up to rounding, at a cost independent of
+    the grid size.
+//}}}*/
+
+/*  Grid memory:
+//{{{
+    All sizes and indices of the grids are size_t, only the points per
+    dimension are int. nx1dPlanCreate() refuses grids whose interpolated
+    array (n_values * nn_points doubles) does not fit into the address space
+    with NX1D_ERROR_SIZE, so no index computation of the passes overflows.
+
+    The intermediate grids of the plan and the arrays of nx1dPlanAlloc() of
+    NX1D_MAP_THRESHOLD bytes or more are anonymous mappings aligned to a huge
+    page. The page mode of the plan (nx1dPlanSetPages) selects
+
+        NX1D_PAGES_DEFAULT  transparent huge pages (madvise), the strided
+                            passes touch far fewer TLB entries
+        NX1D_PAGES_SMALL    base pages only
+        NX1D_PAGES_HUGE     explicit huge pages of the hugetlbfs pool, the
+                            default mode if the pool is too small
+
+    Every page of a new grid is first touched by the threads of the plan in
+    the static schedule of the passes, i.e. thread t touches about the t-th
+    part of the grid, which is the part its lines are read from and written
+    to. On a NUMA machine the pages are thus placed on the node of the thread
+    using them (a new thread count reallocates the intermediate grids for
+    its schedule). A block header of NX1D_BLOCK_HEADER bytes in front of the
+    grid tells nx1dFree() how it was obtained; smaller grids come from the
+    heap.
+//}}}*/
+
+/*  Pipelined execution:
+//{{{
+    The last pass of dimension k writes d_jump superordinate blocks of
+    nq_new[k]*jump values each, and consecutive blocks are consecutive in the
+    interpolated array. nx1dPlanExecuteBlocks() therefore executes the last
+    pass in slabs of whole blocks in index order: every slab is computed by
+    all threads into a buffer obtained from acquire() and handed to release()
+    right away, while the next slab is computed. The interpolated grid never
+    exists as a whole, only the intermediate grid of the second to last pass.
+
+    The slabs are finest if the last pass interpolates the last dimension
+    (one block is one output line); if it interpolates dimension 0 there is
+    a single block. The wall time of the last pass excludes the time spent
+    in acquire() and release(), i.e. waiting for a free buffer.
+//}}}*/
+
+/*  Derivative output:
+//{{{
+    The coefficients b_i, c_i and d_i of every interval also give the
+    derivatives of the line at the interpolation positions,
+
+        f'(t)  = b_i + 2 c_i t + 3 d_i t^2,     f''(t) = 2 c_i + 6 d_i t,
+
+    i.e. the same product with the basis rows (0 1 2t 3t^2) and (0 0 2 6t).
+    The derivative of the tensor product spline along dimension k applies
+    such a row in the pass over k and the value rows in all other passes.
+
+    With nx1dPlanSetDerivatives(plan, order) every grid point carries
+    n_fields = 1 + order*dimension fields of n_values values: the values,
+    the first derivatives along dimension 0 .. dimension-1 and for order 2
+    the second ones (the diagonal of the Hessian). The fields are further
+    values of the innermost dimension (n_channels = n_values*n_fields), so
+    the passes, the pass order, the tiles and the pipelined blocks are
+    unchanged. Before the first pass the input is copied to every field.
+
+    The lines of one group are neighbouring channels and may belong to
+    different fields. nx1dEvaluateLanes therefore takes every row of the
+    basis matrix as vectors holding the row of each lane. lane_basis has
+    such a matrix per dimension k and channel of the first lane of a group,
+    so a derivative along k is evaluated from the coefficients of the pass
+    over k while they are in registers. The largest grid is never read
+    again, and the derivatives are exact for the spline (no differences of
+    the interpolated values).
+//}}}*/
+struct nx1dSpline {
+
+    int dimension;
+    int n_values;           // number of values per grid point
+    int n_subsets;          // 2^dimension
+    int n_threads;
+    int * nq;               // points per dimension
+    size_t * stride;        // index difference of neighbouring points of dimension k
+    double dq;
+    double * origin;        // coordinates of the first grid point
+    double * coef;          // G_S of all subsets S, (point*n_subsets + S)*n_values + value
+};
+
+struct nx1dPlan {
+
+    int dimension;
+    int n_spline;
+    size_t n_points;        // number of points of the input grid
+    size_t nn_points;       // number of points of the interpolated grid
+    int n_values;           // number of values per grid point
+    int n_fields;           // 1 + derivative order * dimension (see "Derivative output")
+    int n_channels;         // n_values * n_fields values per point of the grids
+    int maxdim;             // number of points of the longest dimension
+    int maxdim_lines;       // number of points of the longest dimension solved line by line
+    int n_threads;          // number of threads sharing the lines of a dimension
+    int n_scratch;          // number of scratch vectors per thread
+    int tile_width;         // number of lines per tile of strided passes
+
+    int * nq;               // points per dimension of the input grid
+    int * nq_new;           // points per dimension of the interpolated grid
+    int * order;            // order[p]: dimension interpolated in pass p
+    int * pass;             // pass[k]: pass interpolating dimension k
+    int * solve_long;       // solve_long[p]: lines of pass p are split into chunks
+
+// statistics of every pass of the last execution and the perf_event
+//  counters of the threads of a profiled plan (see "Profiling")
+    nx1dPassStats * stats;
+    int   profile;
+    int   n_counter_threads;
+    int * counter_fd;
+
+// grid spacing dependent constants
+    double dq;
+    double scale;           // 3/dq/dq
+    double inv_dq;          // 1/dq
+    double inv_3dq;         // 1/(3 dq)
+    double dq_3;            // dq/3
+
+// LU factors c'_i of the tridiagonal matrix (and their float copy), the
+//  pole and the factors of the start value w_0 of the recursive filter
+//  engine (see "Recursive filter engine")
+    double * matrix_c;
+    float  * matrix_cf;
+    double   pole;
+    double   filter_init[NX1D_FILTER_TERMS + 1];
+    int      engine;
+    int      precision;     // NX1D_PRECISION_*, element type of the grids (see "Precision modes")
+    int      pages;         // NX1D_PAGES_*, page mode of the grids (see "Grid memory")
+
+// basis matrix, row j holds 1, t_j, t_j^2 and t_j^3 of t_j = j*newdq,
+//  and its columns as n_basis zero padded vectors each (n_basis_f float
+//  vectors each for the float mode)
+    double  * basis;
+    vdouble * basis_t;
+    int       n_basis;
+    vfloat  * basis_tf;
+    int       n_basis_f;
+
+// basis matrices per lane of derivative output, 4*(n_spline+2) vectors for
+//  every dimension and channel of the first lane (see "Derivative output")
+    vdouble * lane_basis;
+    vfloat  * lane_basis_f;
+
+// response of a chunk to its left neighbour (see "Long lines")
+    double spike[NX1D_SPIKE_LENGTH];
+
+// scratch space, n_scratch vectors per thread, the coefficients c of a
+//  long line (followed by the boundary values of its chunks) and the
+//  intermediate grids of even (yy) and odd (aux_yy) passes (see "Grid memory")
+//  and the input copied to all fields of a derivative output
+    vdouble * scratch;
+    double  * long_c;
+    void    * yy;
+    void    * aux_yy;
+    void    * fields;
+};
+
+// output blocks of a pipelined execution (see "Pipelined execution")
+typedef struct nx1dBlocks {
+    size_t           block_points;  // requested number of points per block
+    nx1dAcquireBlock acquire;
+    nx1dReleaseBlock release;
+    void           * data;
+} nx1dBlocks;
+
+// internal prototypes
+static int  nx1dLongChunks(const nx1dPlan * plan, int n_threads, int n);
+static int  nx1dAllocScratch(nx1dPlan * plan, int n_threads);
+static int  nx1dAllocBuffers(nx1dPlan * plan);
+static int  nx1dDefaultThreads(void);
+#ifdef NX1D_PROFILE
+static int  nx1dOpenCounters(nx1dPlan * plan);
+static void nx1dCloseCounters(nx1dPlan * plan);
+static void nx1dReadCounters(const nx1dPlan * plan, double * value);
+static void nx1dStoreCounters(nx1dPassStats * stats, const double * before, const double * after);
+#endif
+static void nx1dPassGeometry(const nx1dPlan * plan, const int * pass, int p, int k, size_t * jump, size_t * d_jump);
+static double nx1dPassCost(const nx1dPlan * plan, const int * pass, int p, int k);
+static void nx1dCostOrder(nx1dPlan * plan);
+static void nx1dFieldRow(const nx1dPlan * plan, int f, int k, int j, double * row);
+static void nx1dExecute(nx1dPlan * plan, const void * v, void * out, void * consumed, const nx1dBlocks * blocks);
+static double nx1dPassBlocks(nx1dPlan * plan, int p, int k, size_t jump, size_t d_jump, const double * src,
+                             const nx1dBlocks * blocks);
+static void nx1dSolveCoefficients(const nx1dPlan * plan, vdouble * scratch, const double * in, double * out,
+                                  size_t jump, const size_t * lane, int n, int width);
+
+
+// index of the calling thread inside a parallel region
+static inline int nx1dThreadNum(void){
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// index of the lane basis of the lines m, m+1, ... of dimension k in the
+//  lane_basis of a derivative output (see "Derivative output")
+static inline size_t nx1dLaneOffset(const nx1dPlan * plan, int k, size_t m){
+    return ((size_t)k * plan->n_channels + m % plan->n_channels) * 4 * (plan->n_spline + 2);
+}
+
+// wall clock time in seconds
+static double nx1dWallTime(void){
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1.0e-9 * t.tv_nsec;
+#endif
+}
+
+
+#ifdef NX1D_PROFILE
+// Open the counters of "Profiling" for every thread of the plan,
+//  counters which can't be opened are marked by a descriptor of -1
+static int nx1dOpenCounters(nx1dPlan * plan){
+
+    int t, e;
+    struct perf_event_attr attr;
+    const uint32_t type[NX1D_N_COUNTERS]   = {PERF_TYPE_SOFTWARE, PERF_TYPE_HARDWARE,
+                                              PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE};
+    const uint64_t config[NX1D_N_COUNTERS] = {PERF_COUNT_SW_TASK_CLOCK, PERF_COUNT_HW_CPU_CYCLES,
+                                              PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+
+    plan->counter_fd = malloc((size_t)plan->n_threads * NX1D_N_COUNTERS * sizeof(int));
+    if(plan->counter_fd == NULL) return NX1D_ERROR_MEMORY;
+    plan->n_counter_threads = plan->n_threads;
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(plan->n_threads) private(t, e, attr)
+#endif
+    {
+        t = nx1dThreadNum();
+        for(e = 0; e < NX1D_N_COUNTERS; ++e){
+            memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = type[e];
+            attr.config         = config[e];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            plan->counter_fd[t * NX1D_N_COUNTERS + e] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+    }
+    return NX1D_SUCCESS;
+}
+
+
+static void nx1dCloseCounters(nx1dPlan * plan){
+
+    int i;
+
+    for(i = 0; plan->counter_fd != NULL && i < plan->n_counter_threads * NX1D_N_COUNTERS; ++i){
+        if(plan->counter_fd[i] >= 0) close(plan->counter_fd[i]);
+    }
+    free(plan->counter_fd);
+    plan->counter_fd        = NULL;
+    plan->n_counter_threads = 0;
+}
+
+
+// Sum of every counter over the threads of the plan, -1 if no thread has it
+static void nx1dReadCounters(const nx1dPlan * plan, double * value){
+
+    int t, e, fd;
+    uint64_t count;
+
+    for(e = 0; e < NX1D_N_COUNTERS; ++e){
+        value[e] = -1.0;
+        for(t = 0; t < plan->n_counter_threads; ++t){
+            fd = plan->counter_fd[t * NX1D_N_COUNTERS + e];
+            if(fd >= 0 && read(fd, &count, sizeof(count)) == sizeof(count)){
+                value[e] = ((value[e] < 0.0) ? 0.0 : value[e]) + (double)count;
+            }
+        }
+    }
+}
+
+
+// Counter differences of a pass, the task clock counts nanoseconds
+static void nx1dStoreCounters(nx1dPassStats * stats, const double * before, const double * after){
+
+    double diff[NX1D_N_COUNTERS];
+    int e;
+
+    for(e = 0; e < NX1D_N_COUNTERS; ++e){
+        diff[e] = (before[e] < 0.0 || after[e] < 0.0) ? -1.0 : after[e] - before[e];
+    }
+    stats->cpu_seconds  = (diff[0] < 0.0) ? -1.0 : 1.0e-9 * diff[0];
+    stats->cycles       = diff[1];
+    stats->instructions = diff[2];
+    stats->cache_misses = diff[3];
+}
+#endif
+
+// Default number of threads: NX1D_NUM_THREADS if set, otherwise
+//  the OpenMP default (which itself honours OMP_NUM_THREADS)
+static int nx1dDefaultThreads(void){
+
+    int n_threads = 1;
+    char * env = getenv("NX1D_NUM_THREADS");
+
+    if(env != NULL && atoi(env) > 0){
+        n_threads = atoi(env);
+    }
+#ifdef _OPENMP
+    else{
+        n_threads = omp_get_max_threads();
+    }
+#else
+    n_threads = 1;
+#endif
+    return n_threads;
+}
+
+
+// Number of chunks a long line of n points is split into by n_threads
+//  threads (see "Long lines"), less than 2 if the line is too short
+static int nx1dLongChunks(const nx1dPlan * plan, int n_threads, int n){
+
+    int n_chunks = n_threads * NX1D_LANES;
+
+    (void)plan;
+    if((n - 1) / n_chunks < NX1D_MIN_CHUNK){
+        n_chunks = (n - 1) / NX1D_MIN_CHUNK;
+    }
+    return n_chunks;
+}
+
+
+// (Re)allocate the private scratch vectors of n_threads threads for the
+//  current pass order, i.e. 4 maxdim_lines vectors for nx1dSolveLines
+//  followed by the input and output tile of nx1dSolveTile, or the longest
+//  chunk of nx1dSolveChunks. Each block is padded to a multiple of 64 bytes
+//  to avoid false sharing. Passes with too few lines to keep all lanes
+//  and threads busy split their lines into chunks.
+static int nx1dAllocScratch(nx1dPlan * plan, int n_threads){
+
+    int p, k;
+    size_t jump, d_jump;
+    int n_chunks, n_lines;
+    int n_long = 0;             // number of vectors of the longest chunk
+    int per_line = (64 > sizeof(vdouble)) ? (int)(64 / sizeof(vdouble)) : 1;
+    int maxdim_new, n_tile;
+
+    plan->n_threads = n_threads;
+
+    for(p = 0, plan->maxdim_lines = 1; p < plan->dimension; ++p){
+        k = plan->order[p];
+        nx1dPassGeometry(plan, plan->pass, p, k, &jump, &d_jump);
+        n_chunks = nx1dLongChunks(plan, n_threads, plan->nq[k]);
+
+    // contiguous lines occupy a single lane each, strided lines fill the
+    //  lanes of a group but may leave threads without a group
+        if(jump == 1){
+            plan->solve_long[p] = (d_jump < (size_t)n_threads * NX1D_LANES && n_chunks >= 2);
+        }else{
+            plan->solve_long[p] = (d_jump * ((jump + NX1D_LANES - 1) / NX1D_LANES) < (size_t)n_threads && n_chunks >= 2);
+        }
+        if(plan->solve_long[p]){
+            n_lines = (plan->nq[k] - 1) - (n_chunks - 1) * ((plan->nq[k] - 1) / n_chunks);
+            if(n_lines > n_long) n_long = n_lines;
+        }else if(plan->nq[k] > plan->maxdim_lines){
+            plan->maxdim_lines = plan->nq[k];
+        }
+    }
+
+// tile width of strided passes, a multiple of NX1D_LANES
+    maxdim_new       = (plan->maxdim_lines - 1) * (plan->n_spline + 1) + 1;
+    plan->tile_width = NX1D_TILE_BYTES / ((plan->maxdim_lines + maxdim_new) * sizeof(double));
+    plan->tile_width = plan->tile_width / NX1D_LANES * NX1D_LANES;
+    if(plan->tile_width < NX1D_LANES)          plan->tile_width = NX1D_LANES;
+    if(plan->tile_width > NX1D_MAX_TILE_WIDTH) plan->tile_width = NX1D_MAX_TILE_WIDTH;
+    n_tile = plan->tile_width / NX1D_LANES * (plan->maxdim_lines + maxdim_new);
+
+    n_lines = 4 * plan->maxdim_lines + n_tile;
+    plan->n_scratch = ((n_lines > n_long ? n_lines : n_long) + per_line - 1) / per_line * per_line;
+
+    free(plan->scratch);
+    free(plan->long_c);
+    plan->scratch = aligned_alloc(sizeof(vdouble) * per_line, (size_t)n_threads * plan->n_scratch * sizeof(vdouble));
+    plan->long_c  = (n_long > 0) ? malloc((plan->maxdim + 2 * n_threads * NX1D_LANES) * sizeof(double)) : NULL;
+
+    return (plan->scratch == NULL || (n_long > 0 && plan->long_c == NULL)) ? 1 : 0;
+}
+
+
+// Create the plan of a grid of nq[0] x ... x nq[dimension-1] points with
+//  n_values values each, the plan is stored to *plan_out (NULL on failure)
+int nx1dPlanCreate(nx1dPlan ** plan_out, const int * nq, double dq, int dimension, int n_spline, int n_values){
+
+    int i, error;
+    size_t n_entries;
+    double newdq, power;
+    double spike_c[2 * NX1D_SPIKE_LENGTH];
+    double spike_d[2 * NX1D_SPIKE_LENGTH];
+    nx1dPlan * plan = NULL;
+
+    if(plan_out == NULL || nq == NULL) return NX1D_ERROR_ARGUMENT;
+    (*plan_out) = NULL;
+
+    if(dimension < 1 || n_spline < 0 || n_values < 1){
+        return NX1D_ERROR_GRID;
+    }
     for(i = 0; i < dimension; ++i){
-        nq[i] = nq_in[i];
+        if(nq[i] < 3) return NX1D_ERROR_GRID;
+    }
+
+// the interpolated points per dimension are int, the n_values values of
+//  all interpolated points have to be addressable (see "Grid memory")
+    for(i = 0, n_entries = (size_t)n_values * sizeof(double); i < dimension; ++i){
+        if(n_spline >= INT_MAX / 2 || nq[i] - 1 > (INT_MAX - 1) / (n_spline + 1)
+        || __builtin_mul_overflow(n_entries, (size_t)(nq[i] - 1) * (n_spline + 1) + 1, &n_entries)
+        || n_entries > PTRDIFF_MAX){
+            return NX1D_ERROR_SIZE;
+        }
+    }
+
+    plan = calloc(1, sizeof(nx1dPlan));
+    if(plan == NULL) return NX1D_ERROR_MEMORY;
+
+    plan->dimension = dimension;
+    plan->n_spline  = n_spline;
+    plan->dq        = dq;
+    plan->n_values  = n_values;
+    plan->n_fields  = 1;
+    plan->n_channels = n_values;
+
+// store old and new grid sizes, determine the size of the dimension
+//  with the most entries and calculate n_points and nn_points
+    plan->nq     = malloc(dimension * sizeof(int));
+    plan->nq_new = malloc(dimension * sizeof(int));
+    plan->order  = malloc(dimension * sizeof(int));
+    plan->pass   = malloc(dimension * sizeof(int));
+    plan->solve_long = malloc(dimension * sizeof(int));
+    plan->stats      = calloc(dimension, sizeof(nx1dPassStats));
+    if(plan->nq == NULL || plan->nq_new == NULL || plan->order == NULL || plan->pass == NULL
+    || plan->solve_long == NULL || plan->stats == NULL){
+        nx1dPlanDestroy(plan);
+        return NX1D_ERROR_MEMORY;
+    }
+    for(i = 0, plan->maxdim = 1, plan->n_points = 1, plan->nn_points = 1; i < dimension; ++i){
+        plan->nq[i]     = nq[i];
+        plan->nq_new[i] = (nq[i] - 1) * (n_spline + 1) + 1;
+        if(nq[i] > plan->maxdim){
+            plan->maxdim = nq[i];
+        }
+        plan->n_points  *= plan->nq[i];
+        plan->nn_points *= plan->nq_new[i];
+    }
+
+// allocate memory for the tables and the scratch space
+//  (vectors are allocated with their natural alignment)
+    plan->matrix_c = malloc(plan->maxdim * sizeof(double));
+    plan->basis    = malloc(4 * (n_spline + 2) * sizeof(double));
+    plan->n_basis  = (n_spline + 2 + NX1D_LANES - 1) / NX1D_LANES;
+    plan->basis_t  = aligned_alloc(sizeof(vdouble), 4 * plan->n_basis * sizeof(vdouble));
+    plan->matrix_cf = malloc(plan->maxdim * sizeof(float));
+    plan->n_basis_f = (n_spline + 2 + NX1D_FLOAT_LANES - 1) / NX1D_FLOAT_LANES;
+    plan->basis_tf  = aligned_alloc(sizeof(vfloat), 4 * plan->n_basis_f * sizeof(vfloat));
+
+    if(plan->matrix_c == NULL || plan->basis == NULL || plan->basis_t == NULL
+    || plan->matrix_cf == NULL || plan->basis_tf == NULL){
+        nx1dPlanDestroy(plan);
+        return NX1D_ERROR_MEMORY;
+    }
+
+// constant factors
+    plan->scale   = 3.0 / dq / dq;
+    plan->inv_dq  = 1.0 / dq;
+    plan->inv_3dq = 1.0 / (3.0 * dq);
+    plan->dq_3    = dq / 3.0;
+
+// LU factors of the tridiagonal matrix
+    plan->matrix_c[0] = 1.0/4.0;
+    for(i = 1; i < plan->maxdim - 1; ++i){
+        plan->matrix_c[i] = 1.0 / (4.0 - plan->matrix_c[i-1]);
+    }
+    for(i = 0; i < plan->maxdim - 1; ++i){
+        plan->matrix_cf[i] = plan->matrix_c[i];
+    }
+
+// pole of the recursive filter engine and the factors of its start value
+//  w_0 = kappa d_0 - kappa^3 sum_j (-kappa)^j d_j
+    plan->pole = 2.0 - sqrt(3.0);
+    plan->filter_init[0] = plan->pole - plan->pole * plan->pole * plan->pole;
+    for(i = 1, power = -plan->pole; i <= NX1D_FILTER_TERMS; ++i, power *= -plan->pole){
+        plan->filter_init[i] = -plan->pole * plan->pole * plan->pole * power;
+    }
+    nx1dPlanSetEngine(plan, NX1D_ENGINE_THOMAS);
+
+// response of a chunk to its left neighbour, i.e. the solution of
+//  T u = -e_0 on a system of 2 NX1D_SPIKE_LENGTH rows (the remaining
+//  entries of a longer system differ by less than kappa^NX1D_SPIKE_LENGTH)
+    spike_c[0] = 1.0/4.0;
+    spike_d[0] = -1.0/4.0;
+    for(i = 1; i < 2 * NX1D_SPIKE_LENGTH; ++i){
+        spike_c[i] = 1.0 / (4.0 - spike_c[i-1]);
+        spike_d[i] = -spike_d[i-1] * spike_c[i];
+    }
+    for(i = 2 * NX1D_SPIKE_LENGTH - 2; i >= 0; --i){
+        spike_d[i] -= spike_c[i] * spike_d[i+1];
+    }
+    for(i = 0; i < NX1D_SPIKE_LENGTH; ++i){
+        plan->spike[i] = spike_d[i];
     }
 
 // define new delta q (newdq) which accounts for interpolated points
+//  and tabulate the basis matrix of the interpolation positions
     newdq = dq / ((double)n_spline + 1.0);
+    for(i = 0; i < n_spline + 2; ++i){
+        plan->basis[4*i]   = 1.0;
+        plan->basis[4*i+1] = newdq * i;
+        plan->basis[4*i+2] = plan->basis[4*i+1] * plan->basis[4*i+1];
+        plan->basis[4*i+3] = plan->basis[4*i+1] * plan->basis[4*i+1] * plan->basis[4*i+1];
+    }
+    for(i = 0; i < 4 * plan->n_basis; ++i){
+        plan->basis_t[i] = (vdouble){0.0};
+    }
+    for(i = 0; i < 4 * (n_spline + 2); ++i){
+        plan->basis_t[i % 4 * plan->n_basis + i / 4 / NX1D_LANES][i / 4 % NX1D_LANES] = plan->basis[i];
+    }
+    for(i = 0; i < 4 * plan->n_basis_f; ++i){
+        plan->basis_tf[i] = (vfloat){0.0};
+    }
+    for(i = 0; i < 4 * (n_spline + 2); ++i){
+        plan->basis_tf[i % 4 * plan->n_basis_f + i / 4 / NX1D_FLOAT_LANES][i / 4 % NX1D_FLOAT_LANES] = plan->basis[i];
+    }
+
+// cheapest pass order and the intermediate buffers and scratch space
+//  it requires
+    plan->n_threads = nx1dDefaultThreads();
+    error = nx1dPlanSetOrder(plan, NULL);
+    if(error != NX1D_SUCCESS){
+        nx1dPlanDestroy(plan);
+        return error;
+    }
+
+    (*plan_out) = plan;
+    return NX1D_SUCCESS;
+}
+
+
+// Set the order of the dimensional passes, order[p] is the dimension
+//  interpolated in pass p. NULL selects the cheapest order (default).
+//  An invalid order leaves the plan unchanged.
+int nx1dPlanSetOrder(nx1dPlan * plan, const int * order){
+
+    int p, q;
+
+    if(plan == NULL) return NX1D_ERROR_ARGUMENT;
+
+    if(order == NULL){
+        nx1dCostOrder(plan);
+    }else{
+        for(p = 0; p < plan->dimension; ++p){
+            if(order[p] < 0 || order[p] >= plan->dimension) return NX1D_ERROR_ORDER;
+            for(q = 0; q < p; ++q){
+                if(order[q] == order[p]) return NX1D_ERROR_ORDER;
+            }
+        }
+        for(p = 0; p < plan->dimension; ++p){
+            plan->order[p]        = order[p];
+            plan->pass[order[p]]  = p;
+        }
+    }
+
+    if(nx1dAllocBuffers(plan) != 0 || nx1dAllocScratch(plan, plan->n_threads) != 0){
+        return NX1D_ERROR_MEMORY;
+    }
+    return NX1D_SUCCESS;
+}
+
+
+// Index difference between two entries of a line (jump) and number of
+//  superordinate blocks (d_jump) of dimension k on the intermediate grid
+//  of pass p, dimension j has been interpolated if pass[j] < p
+static void nx1dPassGeometry(const nx1dPlan * plan, const int * pass, int p, int k, size_t * jump, size_t * d_jump){
+
+    int j;
+
+    for(j = 0, (*jump) = plan->n_channels, (*d_jump) = 1; j < plan->dimension; ++j){
+        if(j < k){
+            (*d_jump) *= (pass[j] < p) ? plan->nq_new[j] : plan->nq[j];
+        }else if(j > k){
+            (*jump)   *= (pass[j] < p) ? plan->nq_new[j] : plan->nq[j];
+        }
+    }
+}
+
+
+// Estimated cost of interpolating dimension k in pass p (see "Pass order")
+static double nx1dPassCost(const nx1dPlan * plan, const int * pass, int p, int k){
+
+    size_t jump, d_jump;
+    double cost;
+
+    nx1dPassGeometry(plan, pass, p, k, &jump, &d_jump);
+
+    cost = (double)d_jump * ((jump + NX1D_LANES - 1) / NX1D_LANES) * (plan->nq[k] + plan->nq_new[k]);
+    if(jump * sizeof(double) >= NX1D_PAGE_SIZE){
+        cost *= 2.0;
+    }
+    return cost;
+}
+
+
+// Determine the cheapest pass order: cost[S] is the minimum cost of
+//  interpolating the subset S of dimensions and last[S] the dimension of
+//  the last pass achieving it. Fall back to the natural order if there
+//  are too many dimensions.
+static void nx1dCostOrder(nx1dPlan * plan){
+
+    int k, p, j;
+    int set, rest;
+    int n_sets;
+    int * last = NULL;
+    int * pass = NULL;
+    double aux;
+    double * cost = NULL;
+
+    if(plan->dimension <= NX1D_MAX_ORDER_DIM){
+        n_sets = 1 << plan->dimension;
+        cost   = malloc(n_sets * sizeof(double));
+        last   = malloc(n_sets * sizeof(int));
+        pass   = malloc(plan->dimension * sizeof(int));
+    }
+
+    if(cost == NULL || last == NULL || pass == NULL){
+        for(p = 0; p < plan->dimension; ++p){
+            plan->order[p] = p;
+            plan->pass[p]  = p;
+        }
+        free(cost);
+        free(last);
+        free(pass);
+        return;
+    }
+
+// the interpolated dimensions are marked by pass[j] = 0, i.e. the
+//  pass cost is evaluated for pass p = 1
+    cost[0] = 0.0;
+    for(set = 1; set < n_sets; ++set){
+        last[set] = -1;
+        for(k = 0; k < plan->dimension; ++k){
+            if(!(set & (1 << k))) continue;
+
+            rest = set & ~(1 << k);
+            for(j = 0; j < plan->dimension; ++j){
+                pass[j] = (rest & (1 << j)) ? 0 : 1;
+            }
+            aux = cost[rest] + nx1dPassCost(plan, pass, 1, k);
+
+        // on ties the larger k goes last, equal costs keep the natural order
+            if(last[set] < 0 || aux <= cost[set]){
+                cost[set] = aux;
+                last[set] = k;
+            }
+        }
+    }
+
+    for(p = plan->dimension-1, set = n_sets-1; p >= 0; --p){
+        plan->order[p]            = last[set];
+        plan->pass[plan->order[p]] = p;
+        set &= ~(1 << last[set]);
+    }
+
+    free(cost);
+    free(last);
+    free(pass);
+}
+
+
+// (Re)allocate the intermediate grids of the current pass order and
+//  precision mode: the grids grow with every pass, even passes are written
+//  to yy, odd ones to aux_yy and the last one to the output array
+static int nx1dAllocBuffers(nx1dPlan * plan){
+
+    int p, j;
+    size_t n_intermediate;
+    size_t size = (plan->precision == NX1D_PRECISION_DOUBLE) ? sizeof(double) : sizeof(float);
+    size_t n_yy[2] = {0, 0};
+
+    for(p = 0; p < plan->dimension - 1; ++p){
+        for(j = 0, n_intermediate = plan->n_channels; j < plan->dimension; ++j){
+            n_intermediate *= (plan->pass[j] <= p) ? plan->nq_new[j] : plan->nq[j];
+        }
+        if(n_intermediate > n_yy[p % 2]){
+            n_yy[p % 2] = n_intermediate;
+        }
+    }
+
+    nx1dFree(plan->yy);
+    nx1dFree(plan->aux_yy);
+    nx1dFree(plan->fields);
+    plan->yy     = (n_yy[0] > 0) ? nx1dPlanAlloc(plan, n_yy[0] * size) : NULL;
+    plan->aux_yy = (n_yy[1] > 0) ? nx1dPlanAlloc(plan, n_yy[1] * size) : NULL;
+    plan->fields = (plan->n_fields > 1) ? nx1dPlanAlloc(plan, plan->n_points * plan->n_channels * size) : NULL;
+
+    return ((n_yy[0] > 0 && plan->yy == NULL) || (n_yy[1] > 0 && plan->aux_yy == NULL)
+         || (plan->n_fields > 1 && plan->fields == NULL)) ? 1 : 0;
+}
+
+
+// Select the coefficient engine, NX1D_ENGINE_THOMAS (default) or
+//  NX1D_ENGINE_FILTER (see "Recursive filter engine")
+int nx1dPlanSetEngine(nx1dPlan * plan, int engine){
+
+    if(plan == NULL) return NX1D_ERROR_ARGUMENT;
+    if(engine != NX1D_ENGINE_THOMAS && engine != NX1D_ENGINE_FILTER){
+        return NX1D_ERROR_ENGINE;
+    }
+    plan->engine = engine;
+
+    return NX1D_SUCCESS;
+}
+
+
+// Select the precision mode (see "Precision modes"): NX1D_PRECISION_DOUBLE
+//  (default) is executed by nx1dPlanExecute(), NX1D_PRECISION_FLOAT and
+//  NX1D_PRECISION_MIXED by nx1dPlanExecuteFloat()
+int nx1dPlanSetPrecision(nx1dPlan * plan, int precision){
+
+    if(plan == NULL) return NX1D_ERROR_ARGUMENT;
+    if(precision != NX1D_PRECISION_DOUBLE && precision != NX1D_PRECISION_FLOAT
+    && precision != NX1D_PRECISION_MIXED){
+        return NX1D_ERROR_PRECISION;
+    }
+    if(precision == plan->precision) return NX1D_SUCCESS;
+
+    plan->precision = precision;
+    return (nx1dAllocBuffers(plan) != 0) ? NX1D_ERROR_MEMORY : NX1D_SUCCESS;
+}
+
+
+// Write the derivatives along every dimension next to the values (see
+//  "Derivative output"): order 0 (values only, default), 1 (first
+//  derivatives) or 2 (first and second derivatives). The grids are
+//  reallocated, the pass order is kept.
+int nx1dPlanSetDerivatives(nx1dPlan * plan, int order){
+
+    int k, c, j, s, e;
+    int n_rows;
+    size_t i, n_entries;
+    double row[4];
+
+    if(plan == NULL) return NX1D_ERROR_ARGUMENT;
+    if(order < 0 || order > 2) return NX1D_ERROR_DERIVATIVES;
+    if(1 + order * plan->dimension == plan->n_fields) return NX1D_SUCCESS;
+
+    if(__builtin_mul_overflow(plan->nn_points, (size_t)plan->n_values * (1 + order * plan->dimension) * sizeof(double),
+                              &n_entries) || n_entries > PTRDIFF_MAX){
+        return NX1D_ERROR_SIZE;
+    }
+    plan->n_fields   = 1 + order * plan->dimension;
+    plan->n_channels = plan->n_values * plan->n_fields;
+
+// lane s of the matrix of dimension k and first channel c belongs to
+//  channel c+s, i.e. to field (c+s)/n_values
+    free(plan->lane_basis);
+    free(plan->lane_basis_f);
+    plan->lane_basis   = NULL;
+    plan->lane_basis_f = NULL;
+    if(plan->n_fields > 1){
+        n_rows = 4 * (plan->n_spline + 2);
+        n_entries = (size_t)plan->dimension * plan->n_channels * n_rows;
+        plan->lane_basis   = aligned_alloc(sizeof(vdouble), n_entries * sizeof(vdouble));
+        plan->lane_basis_f = aligned_alloc(sizeof(vfloat), n_entries * sizeof(vfloat));
+        if(plan->lane_basis == NULL || plan->lane_basis_f == NULL) return NX1D_ERROR_MEMORY;
+
+        for(k = 0; k < plan->dimension; ++k){
+            for(c = 0; c < plan->n_channels; ++c){
+                for(j = 0; j < plan->n_spline + 2; ++j){
+                    i = nx1dLaneOffset(plan, k, c) + 4*j;
+                    for(s = 0; s < NX1D_FLOAT_LANES; ++s){
+                        nx1dFieldRow(plan, (c + s) % plan->n_channels / plan->n_values, k, j, row);
+                        for(e = 0; e < 4; ++e){
+                            if(s < NX1D_LANES) plan->lane_basis[i+e][s] = row[e];
+                            plan->lane_basis_f[i+e][s] = row[e];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if(nx1dAllocBuffers(plan) != 0 || nx1dAllocScratch(plan, plan->n_threads) != 0){
+        return NX1D_ERROR_MEMORY;
+    }
+    return NX1D_SUCCESS;
+}
+
+
+// Row j of the basis matrix of field f in the pass over dimension k (see
+//  "Derivative output"): the value row, or the first or second derivative
+//  row if f is the first or second derivative along k
+static void nx1dFieldRow(const nx1dPlan * plan, int f, int k, int j, double * row){
+
+    double t = plan->basis[4*j+1];
+
+    if(f == 1 + k){
+        row[0] = 0.0;
+        row[1] = 1.0;
+        row[2] = 2.0 * t;
+        row[3] = 3.0 * t * t;
+    }else if(f == 1 + plan->dimension + k){
+        row[0] = 0.0;
+        row[1] = 0.0;
+        row[2] = 2.0;
+        row[3] = 6.0 * t;
+    }else{
+        memcpy(row, plan->basis + 4*j, 4 * sizeof(double));
+    }
+}
+
+
+// Select the page mode of the grids (see "Grid memory"): NX1D_PAGES_DEFAULT,
+//  NX1D_PAGES_SMALL or NX1D_PAGES_HUGE, the intermediate grids are reallocated
+int nx1dPlanSetPages(nx1dPlan * plan, int pages){
+
+    if(plan == NULL) return NX1D_ERROR_ARGUMENT;
+    if(pages != NX1D_PAGES_DEFAULT && pages != NX1D_PAGES_SMALL && pages != NX1D_PAGES_HUGE){
+        return NX1D_ERROR_PAGES;
+    }
+    if(pages == plan->pages) return NX1D_SUCCESS;
+
+    plan->pages = pages;
+    return (nx1dAllocBuffers(plan) != 0) ? NX1D_ERROR_MEMORY : NX1D_SUCCESS;
+}
+
+
+// Allocate a grid of size bytes in the page mode of the plan, first touched
+//  by the threads of the plan (see "Grid memory"). The grid is aligned to 64
+//  bytes and has to be released by nx1dFree(), NULL on failure.
+void * nx1dPlanAlloc(const nx1dPlan * plan, size_t size){
+
+    size_t i, length;
+    char * base = MAP_FAILED;
+    char * data = NULL;
+
+    if(plan == NULL || size > PTRDIFF_MAX - 2 * NX1D_HUGE_PAGE_SIZE) return NULL;
+
+// small grids come from the heap, base NULL marks them in the header
+    if(size + NX1D_BLOCK_HEADER < NX1D_MAP_THRESHOLD){
+        length = (size + 2 * NX1D_BLOCK_HEADER - 1) / NX1D_BLOCK_HEADER * NX1D_BLOCK_HEADER;
+        data   = aligned_alloc(NX1D_BLOCK_HEADER, length);
+        if(data == NULL) return NULL;
+        ((void**)data)[0] = NULL;
+        return data + NX1D_BLOCK_HEADER;
+    }
+    length = (size + NX1D_BLOCK_HEADER + NX1D_HUGE_PAGE_SIZE - 1) / NX1D_HUGE_PAGE_SIZE * NX1D_HUGE_PAGE_SIZE;
+
+// explicit huge pages fail if the pool is too small
+#ifdef MAP_HUGETLB
+    if(plan->pages == NX1D_PAGES_HUGE){
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+
+// otherwise one huge page more is mapped and trimmed to a huge page boundary
+    if(base == MAP_FAILED){
+        base = mmap(NULL, length + NX1D_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(base == MAP_FAILED) return NULL;
+
+        data = (char*)(((uintptr_t)base + NX1D_HUGE_PAGE_SIZE - 1) / NX1D_HUGE_PAGE_SIZE * NX1D_HUGE_PAGE_SIZE);
+        if(data > base){
+            munmap(base, data - base);
+        }
+        if(data < base + NX1D_HUGE_PAGE_SIZE){
+            munmap(data + length, base + NX1D_HUGE_PAGE_SIZE - data);
+        }
+        base = data;
+#ifdef MADV_HUGEPAGE
+        madvise(base, length, (plan->pages == NX1D_PAGES_SMALL) ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+#endif
+    }
+
+// first touch in the static schedule of the passes
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(plan->n_threads) schedule(static)
+#endif
+    for(i = 0; i < length / NX1D_PAGE_SIZE; ++i){
+        base[i * NX1D_PAGE_SIZE] = 0;
+    }
+
+    ((void**)base)[0]  = base;
+    ((size_t*)base)[1] = length;
+    return base + NX1D_BLOCK_HEADER;
+}
+
+
+// Release a grid of nx1dPlanAlloc()
+void nx1dFree(void * data){
+
+    char * block;
+
+    if(data == NULL) return;
+
+    block = (char*)data - NX1D_BLOCK_HEADER;
+    if(((void**)block)[0] == NULL){
+        free(block);
+    }else{
+        munmap(block, ((size_t*)block)[1]);
+    }
+}
+
+
+// Set the number of threads used by nx1dPlanExecute()
+//  (without OpenMP support all work is done by a single thread)
+int nx1dPlanSetThreads(nx1dPlan * plan, int n_threads){
+
+    if(plan == NULL) return NX1D_ERROR_ARGUMENT;
+
+#ifndef _OPENMP
+    n_threads = 1;
+#endif
+    if(n_threads < 1){
+        n_threads = nx1dDefaultThreads();
+    }
+    if(n_threads != plan->n_threads
+    && (nx1dAllocScratch(plan, n_threads) != 0 || nx1dAllocBuffers(plan) != 0)){
+        return NX1D_ERROR_MEMORY;
+    }
+#ifdef NX1D_PROFILE
+    if(plan->profile && plan->n_counter_threads != plan->n_threads){
+        nx1dCloseCounters(plan);
+        return nx1dOpenCounters(plan);
+    }
+#endif
+    return NX1D_SUCCESS;
+}
+
+
+// Switch the profiling of a plan on (profile = 1) or off (0): with a library
+//  built with -DNX1D_PROFILE, a profiled plan reads the perf_event counters
+//  of its threads around every pass (see nx1dPlanPassStats)
+int nx1dPlanSetProfile(nx1dPlan * plan, int profile){
+
+    if(plan == NULL) return NX1D_ERROR_ARGUMENT;
+
+    plan->profile = (profile != 0);
+#ifdef NX1D_PROFILE
+    nx1dCloseCounters(plan);
+    if(plan->profile){
+        return nx1dOpenCounters(plan);
+    }
+#endif
+    return NX1D_SUCCESS;
+}
+
+
+// Description of an error code returned by the nx1dPlan functions
+const char * nx1dErrorString(int error){
+
+    switch(error){
+        case NX1D_SUCCESS:          return "success";
+        case NX1D_ERROR_MEMORY:     return "memory allocation failed";
+        case NX1D_ERROR_GRID:       return "invalid grid, every dimension requires at least 3 points,"
+                                           " n_spline >= 0 and n_values >= 1";
+        case NX1D_ERROR_ORDER:      return "the pass order is no permutation of the dimensions";
+        case NX1D_ERROR_ENGINE:     return "unknown coefficient engine";
+        case NX1D_ERROR_ARGUMENT:   return "missing plan or data array";
+        case NX1D_ERROR_DIMENSION:  return "too many dimensions for scattered point evaluation or an update";
+        case NX1D_ERROR_PRECISION:  return "unknown precision mode or execute call of the wrong precision";
+        case NX1D_ERROR_INDEX:      return "grid index of an update out of range";
+        case NX1D_ERROR_SIZE:       return "the interpolated grid exceeds the address space";
+        case NX1D_ERROR_PAGES:      return "unknown page mode";
+        case NX1D_ERROR_DERIVATIVES: return "unknown derivative order or update of a plan with derivative output";
+        case NX1D_ERROR_POINT:      return "non-finite coordinate of an evaluation point";
+        default:                    return "unknown error";
+    }
+}
+
+
+// Return the number of interpolated points and optionally
+//  store the number of points per dimension in nq_new
+size_t nx1dPlanPoints(const nx1dPlan * plan, int * nq_new){
+
+    int i;
+
+    if(nq_new != NULL){
+        for(i = 0; i < plan->dimension; ++i){
+            nq_new[i] = plan->nq_new[i];
+        }
+    }
+    return plan->nn_points;
+}
+
+
+// Return the number of threads used by nx1dPlanExecute()
+int nx1dPlanGetThreads(const nx1dPlan * plan){
+
+    return plan->n_threads;
+}
+
+
+// Store the current pass order, order[p] is the dimension interpolated in pass p
+int nx1dPlanGetOrder(const nx1dPlan * plan, int * order){
+
+    int p;
+
+    if(plan == NULL || order == NULL) return NX1D_ERROR_ARGUMENT;
+
+    for(p = 0; p < plan->dimension; ++p){
+        order[p] = plan->order[p];
+    }
+    return NX1D_SUCCESS;
+}
+
+
+// Store the statistics of every pass of the last execution, in pass order
+int nx1dPlanPassStats(const nx1dPlan * plan, nx1dPassStats * stats){
+
+    int p;
+
+    if(plan == NULL || stats == NULL) return NX1D_ERROR_ARGUMENT;
+
+    for(p = 0; p < plan->dimension; ++p){
+        stats[p] = plan->stats[p];
+    }
+    return NX1D_SUCCESS;
+}
+
+
+// Store the wall clock seconds every pass of the last execution took,
+//  in pass order (all zero before the first execution)
+int nx1dPlanPassTimes(const nx1dPlan * plan, double * seconds){
+
+    int p;
+
+    if(plan == NULL || seconds == NULL) return NX1D_ERROR_ARGUMENT;
+
+    for(p = 0; p < plan->dimension; ++p){
+        seconds[p] = plan->stats[p].seconds;
+    }
+    return NX1D_SUCCESS;
+}
+
+
+void nx1dPlanDestroy(nx1dPlan * plan){
+
+    if(plan == NULL) return;
+
+    free(plan->nq);
+    free(plan->nq_new);
+    free(plan->order);
+    free(plan->pass);
+    free(plan->solve_long);
+    free(plan->stats);
+#ifdef NX1D_PROFILE
+    nx1dCloseCounters(plan);
+#endif
+    free(plan->long_c);
+    free(plan->matrix_c);
+    free(plan->basis);
+    free(plan->basis_t);
+    free(plan->matrix_cf);
+    free(plan->basis_tf);
+    free(plan->lane_basis);
+    free(plan->lane_basis_f);
+    free(plan->scratch);
+    nx1dFree(plan->yy);
+    nx1dFree(plan->aux_yy);
+    nx1dFree(plan->fields);
+    free(plan);
+}
+
+
+// Kernels of the precision modes (see "Precision modes")
+#define NX1D_T(name)        name##Double
+#define NX1D_STORE          double
+#define NX1D_CALC           double
+#define NX1D_VEC            vdouble
+#define NX1D_VLANES         NX1D_LANES
+#define NX1D_CONVERT        0
+#define NX1D_MATRIX_C(plan) ((plan)->matrix_c)
+#define NX1D_BASIS_T(plan)  ((plan)->basis_t)
+#define NX1D_N_BASIS(plan)  ((plan)->n_basis)
+#define NX1D_LANE_BASIS(plan) ((plan)->lane_basis)
+#include "nx1dKernel.h"
+
+#define NX1D_T(name)        name##Float
+#define NX1D_STORE          float
+#define NX1D_CALC           float
+#define NX1D_VEC            vfloat
+#define NX1D_VLANES         NX1D_FLOAT_LANES
+#define NX1D_CONVERT        0
+#define NX1D_MATRIX_C(plan) ((plan)->matrix_cf)
+#define NX1D_BASIS_T(plan)  ((plan)->basis_tf)
+#define NX1D_N_BASIS(plan)  ((plan)->n_basis_f)
+#define NX1D_LANE_BASIS(plan) ((plan)->lane_basis_f)
+#include "nx1dKernel.h"
+
+#define NX1D_T(name)        name##Mixed
+#define NX1D_STORE          float
+#define NX1D_CALC           double
+#define NX1D_VEC            vdouble
+#define NX1D_VLANES         NX1D_LANES
+#define NX1D_CONVERT        1
+#define NX1D_MATRIX_C(plan) ((plan)->matrix_c)
+#define NX1D_BASIS_T(plan)  ((plan)->basis_t)
+#define NX1D_N_BASIS(plan)  ((plan)->n_basis)
+#define NX1D_LANE_BASIS(plan) ((plan)->lane_basis)
+#include "nx1dKernel.h"
+
+
+// Apply plan to the input array v, the interpolated data is written to out
+//  which has to provide space for nx1dPlanPoints(plan, NULL) * n_values doubles
+//  (times 1 + order*dimension with derivative output).
+//  All memory is owned by the plan, no allocation takes place.
+int nx1dPlanExecute(nx1dPlan * plan, const double * v, double * out){
+
+    if(plan == NULL || v == NULL || out == NULL) return NX1D_ERROR_ARGUMENT;
+    if(plan->precision != NX1D_PRECISION_DOUBLE) return NX1D_ERROR_PRECISION;
+
+    nx1dExecute(plan, v, out, NULL, NULL);
+    return NX1D_SUCCESS;
+}
+
+
+// Same as nx1dPlanExecute(), but the (malloc'ed) input array v is freed as
+//  soon as the first dimension has consumed it
+int nx1dPlanExecuteConsume(nx1dPlan * plan, double * v, double * out){
+
+    if(plan == NULL || v == NULL || out == NULL) return NX1D_ERROR_ARGUMENT;
+    if(plan->precision != NX1D_PRECISION_DOUBLE) return NX1D_ERROR_PRECISION;
+
+    nx1dExecute(plan, v, out, v, NULL);
+    return NX1D_SUCCESS;
+}
+
+
+// nx1dPlanExecute() of a plan in one of the float precision modes
+int nx1dPlanExecuteFloat(nx1dPlan * plan, const float * v, float * out){
+
+    if(plan == NULL || v == NULL || out == NULL) return NX1D_ERROR_ARGUMENT;
+    if(plan->precision == NX1D_PRECISION_DOUBLE) return NX1D_ERROR_PRECISION;
+
+    nx1dExecute(plan, v, out, NULL, NULL);
+    return NX1D_SUCCESS;
+}
+
+
+// Number of points of the blocks of nx1dPlanExecuteBlocks() for a requested
+//  size of block_points: a multiple of the points of one superordinate block
+//  of the last pass, at least one block and at most the interpolated grid
+size_t nx1dPlanBlockPoints(const nx1dPlan * plan, size_t block_points){
+
+    int k = plan->order[plan->dimension-1];
+    size_t jump, d_jump, line, n_sub;
+
+    nx1dPassGeometry(plan, plan->pass, plan->dimension-1, k, &jump, &d_jump);
+
+    line  = plan->nq_new[k] * jump / plan->n_channels;
+    n_sub = block_points / line;
+    if(n_sub < 1)      n_sub = 1;
+    if(n_sub > d_jump) n_sub = d_jump;
+
+    return n_sub * line;
+}
+
+
+// Pipelined nx1dPlanExecute() (see "Pipelined execution"): the interpolated
+//  grid is produced in blocks of nx1dPlanBlockPoints(plan, block_points)
+//  points in index order (the last block may be smaller). acquire(data)
+//  returns a buffer for the n_values values of all points of a block, the
+//  computed block is passed to release(block, n_points, data).
+int nx1dPlanExecuteBlocks(nx1dPlan * plan, const double * v, size_t block_points,
+                          nx1dAcquireBlock acquire, nx1dReleaseBlock release, void * data){
+
+    nx1dBlocks blocks;
+
+    if(plan == NULL || v == NULL || acquire == NULL || release == NULL) return NX1D_ERROR_ARGUMENT;
+    if(plan->precision != NX1D_PRECISION_DOUBLE) return NX1D_ERROR_PRECISION;
+
+    blocks.block_points = block_points;
+    blocks.acquire      = acquire;
+    blocks.release      = release;
+    blocks.data         = data;
+
+    nx1dExecute(plan, v, NULL, NULL, &blocks);
+    return NX1D_SUCCESS;
+}
+
+
+// Add the interpolation of the changes delta of the input points index to
+//  the previous result out (see "Incremental update")
+int nx1dPlanUpdate(nx1dPlan * plan, const int * index, const double * delta, int n_changes, double * out){
+
+    int c, k, s, error;
+    int dimension;
+    size_t j, r, n_rows, base, width;
+    size_t stride[NX1D_MAX_ORDER_DIM];
+    int lo[NX1D_MAX_ORDER_DIM], hi[NX1D_MAX_ORDER_DIM];
+    double f;
+    double * unit = NULL;
+    double * response[NX1D_MAX_ORDER_DIM] = {NULL};
+    const double * r_last = NULL;
+    nx1dPlan * line = NULL;
+
+    if(plan == NULL || out == NULL || (n_changes > 0 && (index == NULL || delta == NULL))){
+        return NX1D_ERROR_ARGUMENT;
+    }
+    if(plan->precision != NX1D_PRECISION_DOUBLE) return NX1D_ERROR_PRECISION;
+    if(plan->dimension > NX1D_MAX_ORDER_DIM)     return NX1D_ERROR_DIMENSION;
+    if(plan->n_fields > 1)                       return NX1D_ERROR_DERIVATIVES;
+    dimension = plan->dimension;
+    for(c = 0; c < n_changes * dimension; ++c){
+        if(index[c] < 0 || index[c] >= plan->nq[c % dimension]) return NX1D_ERROR_INDEX;
+    }
+    if(n_changes == 0) return NX1D_SUCCESS;
+
+// the columns R_k[., i_k] of all changes, response[k][j*n_changes + c]
+    error = NX1D_SUCCESS;
+    for(k = 0; k < dimension && error == NX1D_SUCCESS; ++k){
+        error = nx1dPlanCreate(&line, &plan->nq[k], plan->dq, 1, plan->n_spline, n_changes);
+        if(error == NX1D_SUCCESS) error = nx1dPlanSetEngine(line, plan->engine);
+        if(error == NX1D_SUCCESS) error = nx1dPlanSetThreads(line, plan->n_threads);
+        unit        = calloc((size_t)plan->nq[k] * n_changes, sizeof(double));
+        response[k] = malloc((size_t)plan->nq_new[k] * n_changes * sizeof(double));
+        if(error == NX1D_SUCCESS && (unit == NULL || response[k] == NULL)){
+            error = NX1D_ERROR_MEMORY;
+        }
+        if(error == NX1D_SUCCESS){
+            for(c = 0; c < n_changes; ++c){
+                unit[(size_t)index[c * dimension + k] * n_changes + c] = 1.0;
+            }
+            error = nx1dPlanExecute(line, unit, response[k]);
+        }
+        free(unit);
+        nx1dPlanDestroy(line);
+        line = NULL;
+    }
+
+    for(k = dimension-1, j = 1; k >= 0; --k){
+        stride[k] = j;
+        j *= plan->nq_new[k];
+    }
+
+    for(c = 0; c < n_changes && error == NX1D_SUCCESS; ++c){
+
+    // box of the entries of the responses above the cutoff
+        for(k = 0, n_rows = 1; k < dimension; ++k){
+            for(lo[k] = 0; lo[k] < plan->nq_new[k]-1
+                        && fabs(response[k][(size_t)lo[k] * n_changes + c]) < NX1D_UPDATE_CUTOFF; ++lo[k]);
+            for(hi[k] = plan->nq_new[k]-1; hi[k] > lo[k]
+                        && fabs(response[k][(size_t)hi[k] * n_changes + c]) < NX1D_UPDATE_CUTOFF; --hi[k]);
+            if(k < dimension-1) n_rows *= hi[k] - lo[k] + 1;
+        }
+        width  = hi[dimension-1] - lo[dimension-1] + 1;
+        r_last = response[dimension-1] + (size_t)lo[dimension-1] * n_changes + c;
+
+    // the rows of the box along the last dimension are distinct, hence
+    //  they are distributed over the threads
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(plan->n_threads) schedule(static) private(k, s, j, base, f)
+#endif
+        for(r = 0; r < n_rows; ++r){
+            for(k = dimension-2, j = r, f = 1.0, base = lo[dimension-1]; k >= 0; --k){
+                base += (lo[k] + j % (hi[k] - lo[k] + 1)) * stride[k];
+                f    *= response[k][(lo[k] + j % (hi[k] - lo[k] + 1)) * n_changes + c];
+                j    /= hi[k] - lo[k] + 1;
+            }
+            for(j = 0; j < width; ++j){
+                for(s = 0; s < plan->n_values; ++s){
+                    out[(base + j) * plan->n_values + s] += f * r_last[j * n_changes] * delta[(size_t)c * plan->n_values + s];
+                }
+            }
+        }
+    }
+
+    for(k = 0; k < dimension; ++k){
+        free(response[k]);
+    }
+    return error;
+}
+
+
+// Dimensional loop of nx1dPlanExecute(), the elements of v and out are of
+//  the type of the precision mode. If consumed is not NULL it is freed
+//  right after the first dimension. If blocks is not NULL the last pass
+//  is written to the blocks instead of out (see "Pipelined execution").
+static void nx1dExecute(nx1dPlan * plan, const void * v, void * out, void * consumed, const nx1dBlocks * blocks){
+
+    int p, k, f;
+    size_t i, n_bytes;
+    double start, waited;
+    double size = (plan->precision == NX1D_PRECISION_DOUBLE) ? sizeof(double) : sizeof(float);
+#ifdef NX1D_PROFILE
+    double before[NX1D_N_COUNTERS], after[NX1D_N_COUNTERS];
+#endif
+
+// source and destination of the current dimension
+    const void * src = v;
+    void       * dst = NULL;
+
+// variables for dimensional loop
+//  to break down n-dimensional arrays to a set of 1D arrays
+    size_t jump;          // Index difference between the nth and (n+1)th entry for a given dimension
+    size_t d_jump;        // The number of jumps because of superordinate dimensions
 
 //----------------------------------------------------------------------------------------------------
 //  Dimensional loop    Dimensional loop    Dimensional loop    Dimensional loop    Dimensional loop
@@ -250,104 +1821,408 @@ int nx1dInterpolation(double** v, int* nq_in, double dq, int dimension, int n_sp
     return 0;
 //}}}*/
 
-    for(k = 0, jump = n_points, d_jump = 1; k < dimension; ++k){
+// For every dimension the lines are processed in groups of NX1D_LANES
+//  neighbouring m values (see nx1dSolveLines). The offset of the l-th
+//  group of lines is the length of one superordinate block, i.e. nq[k]*jump
+//  on the input array and the interpolated length times jump on the output.
+//  The dimensions are processed in the order of the plan (which only
+//  changes jump and d_jump of each pass, not the layout), the last pass
+//  is directly written to out, all others alternate between the two
+//  intermediate arrays of the plan.
+//  With derivative output every field starts as a copy of the input
+//  (see "Derivative output").
+    if(plan->n_fields > 1){
+        n_bytes = (size_t)size * plan->n_values;
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(plan->n_threads) schedule(static) private(f)
+#endif
+        for(i = 0; i < plan->n_points; ++i){
+            for(f = 0; f < plan->n_fields; ++f){
+                memcpy((char*)plan->fields + (i * plan->n_fields + f) * n_bytes, (const char*)v + i * n_bytes, n_bytes);
+            }
+        }
+        src = plan->fields;
+    }
 
-        n_iteration = n_points/nq[k];
-        jump /= nq[k];
+    for(p = 0; p < plan->dimension; ++p){
 
-        for(l = 0; l < d_jump; ++l){
-            for(m = 0; m < n_iteration/d_jump; ++m){
+        k = plan->order[p];
+        nx1dPassGeometry(plan, plan->pass, p, k, &jump, &d_jump);
 
-            //----------------------------------------------------------------------
-            //   Forward sweep   Forward sweep   Forward sweep   Forward sweep
-            //----------------------------------------------------------------------
-            // fill matrix_d array with tridiagonal matrix d elements
-                matrix_d[0] = 0.0;
-                for(i = 1; i < nq[k]-1; ++i){
-                    matrix_d[i] = 3/dq/dq * (   (*v)[(i-1)*jump + m + l*offset]
-                                             -2*(*v)[ i   *jump + m + l*offset]
-                                             +  (*v)[(i+1)*jump + m + l*offset]);
-                }
+        if(p == plan->dimension-1){
+            dst = out;
+        }else{
+            dst = (p % 2 == 0) ? plan->yy : plan->aux_yy;
+        }
+        start  = nx1dWallTime();
+        waited = 0.0;
+#ifdef NX1D_PROFILE
+        if(plan->profile) nx1dReadCounters(plan, before);
+#endif
+
+    // the kernels of the precision mode process the lines (nx1dKernel.h)
+        if(p == plan->dimension-1 && blocks != NULL){
+            waited = nx1dPassBlocks(plan, p, k, jump, d_jump, src, blocks);
+        }else{
+            switch(plan->precision){
+                case NX1D_PRECISION_FLOAT:
+                    nx1dPassFloat(plan, p, k, jump, d_jump, src, dst);
+                    break;
+                case NX1D_PRECISION_MIXED:
+                    nx1dPassMixed(plan, p, k, jump, d_jump, src, dst);
+                    break;
+                default:
+                    nx1dPassDouble(plan, p, k, jump, d_jump, src, dst);
+                    break;
+            }
+        }
+        plan->stats[p].seconds = nx1dWallTime() - start - waited;
+
+    // statistics of the pass, the counters are only read by profiled plans
+        plan->stats[p].dimension    = k;
+        plan->stats[p].lines        = (double)d_jump * jump;
+        plan->stats[p].bytes        = (double)d_jump * jump * (plan->nq[k] + plan->nq_new[k]) * size;
+        plan->stats[p].cpu_seconds  = -1.0;
+        plan->stats[p].cycles       = -1.0;
+        plan->stats[p].instructions = -1.0;
+        plan->stats[p].cache_misses = -1.0;
+#ifdef NX1D_PROFILE
+        if(plan->profile){
+            nx1dReadCounters(plan, after);
+            nx1dStoreCounters(&plan->stats[p], before, after);
+        }
+#endif
 
-            // calculate tridiagonal matrix elements c' and d' and save them to
-            //  matrix_c and matrix_d, respectively (overwrite matrix_d)
-                matrix_c[0] = 1.0/4.0;
-                for(i = 1; i < nq[k]-2; ++i){
-                    matrix_c[i] = 1.0 / (4.0 - matrix_c[i-1]);
-                    matrix_d[i] = (matrix_d[i] - matrix_d[i-1]) * matrix_c[i];
-                }
+    // the interpolated data is the source of the next dimension,
+    //  the input is not needed anymore after the first one
+        if(p == 0 && consumed != NULL){
+            free(consumed);
+            consumed = NULL;
+        }
+        src = dst;
+    }
+}
 
 
-            //----------------------------------------------------------------------
-            // Back substitution to determine inter_c coefficients and interpolation
-            //----------------------------------------------------------------------
-            // solve the last entry of the matrix problem
-                inter_c[i] = (matrix_d[i] - matrix_d[i-1]) / (4.0 - matrix_c[i-1]);
+// Last pass of a pipelined execution (see "Pipelined execution"): the
+//  superordinate blocks of src are interpolated slab by slab into the
+//  buffers of blocks. Returns the seconds spent in acquire() and release().
+static double nx1dPassBlocks(nx1dPlan * plan, int p, int k, size_t jump, size_t d_jump, const double * src,
+                             const nx1dBlocks * blocks){
 
-            // calculate inter_b and inter_d values from inter_c
-                inter_d = - inter_c[i] / (3.0 * dq);
-                inter_b = ((*v)[(i+1)*jump + m + l*offset] - (*v)[i*jump + m + l*offset]) / dq - (2.0 / 3.0 * dq * inter_c[i]);
+    size_t l, n_sub, n;
+    size_t line = plan->nq_new[k] * jump / plan->n_channels;
+    double start;
+    double waited = 0.0;
+    double * block = NULL;
 
-            // interpolation procedure for the last n_spline+1 points
-                for(j = n_spline+1; j >= 0; --j){
-                    yy[(i * (n_spline+1) + j)*jump + m + l*inter_offset]
-                                            = (*v)[i*jump + m + l*offset]
-                                            + inter_b    * (newdq*j)
-                                            + inter_c[i] * (newdq*j) * (newdq*j)
-                                            + inter_d    * (newdq*j) * (newdq*j) * (newdq*j);
-                }
+    n_sub = nx1dPlanBlockPoints(plan, blocks->block_points) / line;
 
-                for(i = nq[k]-3; i >= 0; --i){
-                // solve the rest of the matrix problem from back to front
-                    inter_c[i] = matrix_d[i] - matrix_c[i] * inter_c[i+1];
+    for(l = 0; l < d_jump; l += n){
+        n = (d_jump - l < n_sub) ? d_jump - l : n_sub;
 
-                // calculate inter_b and inter_d values from inter_c
-                    inter_d = (inter_c[i+1] - inter_c[i]) / (3.0 * dq);
-                    inter_b = ((*v)[(i+1)*jump + m + l*offset] - (*v)[i*jump + m + l*offset]) / dq - dq / 3.0 * (2.0 * inter_c[i] + inter_c[i+1]);
+        start = nx1dWallTime();
+        block = blocks->acquire(blocks->data);
+        waited += nx1dWallTime() - start;
 
+        nx1dPassDouble(plan, p, k, jump, n, src + l * plan->nq[k] * jump, block);
 
-                // interpolation procedure for the remaining points (all but the last set)
-                    for(j = n_spline; j >= 0; --j){
-                        yy[(i * (n_spline+1) + j)*jump + m + l*inter_offset]
-                                                = (*v)[i*jump + m + l*offset]
-                                                + inter_b    * (newdq*j)
-                                                + inter_c[i] * (newdq*j) * (newdq*j)
-                                                + inter_d    * (newdq*j) * (newdq*j) * (newdq*j);
-                    }
-                }
+        start = nx1dWallTime();
+        blocks->release(block, n * line, blocks->data);
+        waited += nx1dWallTime() - start;
+    }
+    return waited;
+}
+
+
+// Single shot interpolation: set up a plan, interpolate *v and replace it
+//  by the interpolated array of at most max_points points (the original *v
+//  is freed), the number of interpolated points is stored to *nn_points.
+//  On failure *v is left untouched.
+static int nx1dInterpolateLimited(double ** v, const int * nq, double dq, int dimension, int n_spline,
+                                  size_t max_points, size_t * nn_points){
+
+    int error;
+    size_t n_points;
+    double   * yy   = NULL;
+    nx1dPlan * plan = NULL;
+
+    if(v == NULL || *v == NULL) return NX1D_ERROR_ARGUMENT;
+
+    error = nx1dPlanCreate(&plan, nq, dq, dimension, n_spline, 1);
+    if(error != NX1D_SUCCESS) return error;
+
+    n_points = nx1dPlanPoints(plan, NULL);
+    if(n_points > max_points){
+        nx1dPlanDestroy(plan);
+        return NX1D_ERROR_SIZE;
+    }
+
+    yy = malloc(n_points * sizeof(double));
+    if(yy == NULL){
+        nx1dPlanDestroy(plan);
+        return NX1D_ERROR_MEMORY;
+    }
+
+    nx1dPlanExecuteConsume(plan, *v, yy);
+    (*v) = yy;
+
+    nx1dPlanDestroy(plan);
+
+    if(nn_points != NULL) (*nn_points) = n_points;
+    return NX1D_SUCCESS;
+}
+
+
+// Single shot interpolation reporting errors by return code
+int nx1dInterpolate(double ** v, const int * nq, double dq, int dimension, int n_spline, size_t * nn_points){
+
+    return nx1dInterpolateLimited(v, nq, dq, dimension, n_spline, SIZE_MAX, nn_points);
+}
+
+
+// Single shot interpolation with the interface of the original function,
+//  returns the number of interpolated points or 0 on failure
+int nx1dInterpolation(double** v, int* nq_in, double dq, int dimension, int n_spline){
+
+    size_t nn_points = 0;
+
+    if(nx1dInterpolateLimited(v, nq_in, dq, dimension, n_spline, INT_MAX, &nn_points) != NX1D_SUCCESS){
+        return 0;
+    }
+    return (int)nn_points;
+}
+
+
+// Coefficients c of <width> lines of n points (see "Scattered points"):
+//  entry i of line s is in[i*jump + lane[s]], its coefficient is stored
+//  to out[i*jump + lane[s]]. scratch provides 2n vectors.
+static void nx1dSolveCoefficients(const nx1dPlan * plan, vdouble * scratch, const double * in, double * out,
+                                  size_t jump, const size_t * lane, int n, int width){
+
+    int i, j, s;
+    int filter = (plan->engine == NX1D_ENGINE_FILTER && n > NX1D_FILTER_TERMS + 1);
+    vdouble c;
+    vdouble * matrix_d = scratch;
+    vdouble * line     = scratch + n;
+    const double   pole     = plan->pole;
+    const double * matrix_c = plan->matrix_c;
+
+    for(i = 0; i < n; ++i){
+        line[i] = (vdouble){0.0};
+        for(s = 0; s < width; ++s){
+            line[i][s] = in[i*jump + lane[s]];
+        }
+    }
+
+// forward sweep as in nx1dSolveLines
+    matrix_d[0] = (vdouble){0.0};
+    for(i = 1; i < n-1; ++i){
+        matrix_d[i] = plan->scale * (line[i-1] - 2*line[i] + line[i+1]);
+        if(!filter){
+            matrix_d[i] = (matrix_d[i] - matrix_d[i-1]) * matrix_c[i];
+        }
+    }
+    if(filter){
+        for(j = NX1D_FILTER_TERMS, c = (vdouble){0.0}; j >= 0; --j){
+            c += plan->filter_init[j] * matrix_d[j];
+        }
+        matrix_d[0] = c;
+        for(i = 1; i < n-1; ++i){
+            matrix_d[i] = (matrix_d[i] - matrix_d[i-1]) * pole;
+        }
+    }
+
+// back substitution with the natural boundary c_{n-1} = 0
+    c = (vdouble){0.0};
+    for(i = n-1; i >= 0; --i){
+        if(i < n-1){
+            c = matrix_d[i] - (filter ? pole : matrix_c[i]) * c;
+        }
+        for(s = 0; s < width; ++s){
+            out[i*jump + lane[s]] = c[s];
+        }
+    }
+}
+
+
+// Compute the coefficient tensor of the data v on the grid of plan (see
+//  "Scattered points"), origin holds the coordinates of the first grid
+//  point (NULL: 0). The spline is independent of the plan once created.
+int nx1dSplineCreate(nx1dSpline ** spline_out, nx1dPlan * plan, const double * v, const double * origin){
+
+    int k, S, width;
+    int n_subsets;
+    size_t l, g, s, n_groups, n_lines, n_inner, d_jump;
+    size_t n_block, jump, i;
+    size_t lane[NX1D_LANES];
+    const double * in = NULL;
+    vdouble * scratch = NULL;
+    nx1dSpline * spline = NULL;
+
+    if(spline_out == NULL || plan == NULL || v == NULL) return NX1D_ERROR_ARGUMENT;
+    (*spline_out) = NULL;
+    if(plan->dimension > NX1D_MAX_SPLINE_DIM) return NX1D_ERROR_DIMENSION;
+
+    n_subsets = 1 << plan->dimension;
+    n_block   = (size_t)n_subsets * plan->n_values;
+
+    spline = calloc(1, sizeof(nx1dSpline));
+    if(spline == NULL) return NX1D_ERROR_MEMORY;
+    spline->nq     = malloc(plan->dimension * sizeof(int));
+    spline->stride = malloc(plan->dimension * sizeof(size_t));
+    spline->origin = malloc(plan->dimension * sizeof(double));
+    spline->coef   = malloc(plan->n_points * n_block * sizeof(double));
+    scratch        = aligned_alloc(sizeof(vdouble), (size_t)plan->n_threads * 2 * plan->maxdim * sizeof(vdouble));
+    if(spline->nq == NULL || spline->stride == NULL || spline->origin == NULL || spline->coef == NULL
+    || scratch == NULL){
+        free(scratch);
+        nx1dSplineDestroy(spline);
+        return NX1D_ERROR_MEMORY;
+    }
+
+    spline->dimension = plan->dimension;
+    spline->n_values  = plan->n_values;
+    spline->n_subsets = n_subsets;
+    spline->n_threads = plan->n_threads;
+    spline->dq        = plan->dq;
+    for(k = plan->dimension-1, i = 1; k >= 0; --k){
+        spline->nq[k]     = plan->nq[k];
+        spline->stride[k] = i;
+        spline->origin[k] = (origin != NULL) ? origin[k] : 0.0;
+        i *= plan->nq[k];
+    }
+
+// G_{} is the data itself
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(plan->n_threads) schedule(static) private(s)
+#endif
+    for(l = 0; l < plan->n_points; ++l){
+        for(s = 0; s < (size_t)plan->n_values; ++s){
+            spline->coef[l * n_block + s] = v[l * plan->n_values + s];
+        }
+    }
+
+// dimension k turns every G_S with S ⊆ {0..k-1} into G_{S+k}, the lines of
+//  a block of d_jump are formed by the n_inner (point, value) pairs behind
+//  dimension k, NX1D_LANES of them are solved together
+    for(k = 0, d_jump = 1; k < plan->dimension; d_jump *= plan->nq[k], ++k){
+
+        n_inner  = spline->stride[k] * plan->n_values;
+        jump     = spline->stride[k] * n_block;
+        n_groups = (n_inner + NX1D_LANES - 1) / NX1D_LANES;
+        n_lines  = d_jump * n_groups;
+
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(plan->n_threads) schedule(static) private(S, l, s, i, width, lane, in)
+#endif
+        for(g = 0; g < ((size_t)1 << k) * n_lines; ++g){
+
+            S = g / n_lines;
+            l = g % n_lines / n_groups;
+            s = g % n_groups * NX1D_LANES;
+
+            width = (n_inner - s < NX1D_LANES) ? (int)(n_inner - s) : NX1D_LANES;
+            for(i = 0; i < (size_t)width; ++i){
+                lane[i] = (s + i) / plan->n_values * n_block + (s + i) % plan->n_values;
             }
+
+            in = spline->coef + l * plan->nq[k] * jump + (size_t)S * plan->n_values;
+            nx1dSolveCoefficients(plan, scratch + (size_t)nx1dThreadNum() * 2 * plan->maxdim,
+                                  in, (double*)in + ((size_t)1 << k) * plan->n_values,
+                                  jump, lane, plan->nq[k], width);
+        }
+    }
+
+    free(scratch);
+
+    (*spline_out) = spline;
+    return NX1D_SUCCESS;
+}
+
+
+// Evaluate the spline at the n_x points x[p*dimension .. (p+1)*dimension),
+//  the n_values values of point p are stored to out[p*n_values ..]
+int nx1dSplineEvaluate(const nx1dSpline * spline, const double * x, int n_x, double * out){
+
+    int p, k, e, S, s, n_subsets;
+    int idx;
+    size_t node, base;
+    double t, h, sum, cell;
+    double w[NX1D_MAX_SPLINE_DIM][2][2];
+    double ws[1 << NX1D_MAX_SPLINE_DIM];
+    const double * coef = NULL;
+
+    if(spline == NULL || x == NULL || out == NULL) return NX1D_ERROR_ARGUMENT;
+    for(p = 0; p < n_x; ++p){
+        for(k = 0; k < spline->dimension; ++k){
+            if(!isfinite(x[(size_t)p * spline->dimension + k])) return NX1D_ERROR_POINT;
         }
+    }
 
-    // update *v to point to yy, swap yy and aux_yy
-    //  and initialize new yy to zero.
-        (*v) = yy;
+    h         = spline->dq;
+    n_subsets = spline->n_subsets;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(spline->n_threads) schedule(static) \
+                             private(k, e, S, s, idx, node, base, t, sum, cell, w, ws, coef)
+#endif
+    for(p = 0; p < n_x; ++p){
+
+    // cell and weights A, B, C and D of every dimension, points outside of
+    //  the grid are extrapolated from the boundary cell (clamped in double,
+    //  the cast of a cell index beyond INT_MAX is undefined)
+        for(k = 0, base = 0; k < spline->dimension; ++k){
+            t    = x[(size_t)p * spline->dimension + k] - spline->origin[k];
+            cell = floor(t / h);
+            if(cell < 0.0)                cell = 0.0;
+            if(cell > spline->nq[k] - 2)  cell = spline->nq[k] - 2;
+            idx  = (int)cell;
+            t -= idx * h;
+            base += idx * spline->stride[k];
+
+            w[k][0][0] = 1.0 - t / h;
+            w[k][1][0] = t / h;
+            w[k][0][1] = t * t - 2.0/3.0 * h * t - t * t * t / (3.0 * h);
+            w[k][1][1] = t * t * t / (3.0 * h) - h * t / 3.0;
+        }
 
-        yy = aux_yy;
-        for(i = 0; i < nn_points; ++i){
-            yy[i] = 0;
+        for(s = 0; s < spline->n_values; ++s){
+            out[(size_t)p * spline->n_values + s] = 0.0;
         }
-        aux_yy = (*v);
 
-    // update size of dimension and n_points
-        n_points /= nq[k];
-        nq[k]     = (nq[k]-1) * (n_spline+1) + 1;
-        n_points *= nq[k];
+    // the 2^d corners of the cell
+        for(e = 0; e < n_subsets; ++e){
 
-        offset = jump;
-        inter_offset = (jump-1) * (n_spline+1) + 1;
+            for(k = 0, node = base, ws[0] = 1.0; k < spline->dimension; ++k){
+                node += ((e >> k) & 1) * spline->stride[k];
+                for(S = 0; S < (1 << k); ++S){
+                    ws[S + (1 << k)] = ws[S] * w[k][(e >> k) & 1][1];
+                    ws[S]           *= w[k][(e >> k) & 1][0];
+                }
+            }
 
-        d_jump *= nq[k];
+            coef = spline->coef + node * n_subsets * spline->n_values;
+            for(s = 0; s < spline->n_values; ++s){
+                for(S = 0, sum = 0.0; S < n_subsets; ++S){
+                    sum += ws[S] * coef[S * spline->n_values + s];
+                }
+                out[(size_t)p * spline->n_values + s] += sum;
+            }
+        }
     }
 
+    return NX1D_SUCCESS;
+}
+
 
-// free memory
-    free(matrix_c); matrix_c = NULL;
-    free(matrix_d); matrix_d = NULL;
-    free(inter_c);  inter_c  = NULL;
-    free(aux_v);    aux_v    = NULL;
-    free(yy);       yy       = NULL;
-    free(nq);       nq       = NULL;
+void nx1dSplineDestroy(nx1dSpline * spline){
 
-    return n_points;
+    if(spline == NULL) return;
 
+    free(spline->nq);
+    free(spline->stride);
+    free(spline->origin);
+    free(spline->coef);
+    free(spline);
 }
@@ -0,0 +1,145 @@
+#ifndef NX1D_INTERPOLATOR_H
+#define NX1D_INTERPOLATOR_H
+
+#include <stddef.h>
+
+// Interpolation plan:
+//  All quantities of the n-dimensional spline interpolation which only depend
+//  on the grid (nq, dq and n_spline) and not on the data are computed once by
+//  nx1dPlanCreate(). The plan is then applied to an arbitrary number of data
+//  arrays of that grid by nx1dPlanExecute(), which writes to a caller provided
+//  array and does not allocate any memory.
+//  Each grid point carries n_values values, stored next to each other
+//  (i.e. as an additional, not interpolated, innermost dimension).
+//
+//  The plan functions never terminate the process, they return NX1D_SUCCESS
+//  or one of the error codes below (see nx1dErrorString()). After a failed
+//  allocation (NX1D_ERROR_MEMORY) a plan can only be destroyed.
+//  This header and nx1dInterpolator.c form libnx1d (make lib).
+typedef struct nx1dPlan nx1dPlan;
+
+// Statistics of a dimensional pass of the last execution (nx1dPlanPassStats).
+//  The counters are summed over the threads and only read by a library built
+//  with -DNX1D_PROFILE for a plan with nx1dPlanSetProfile(plan, 1),
+//  unavailable counters are -1.
+typedef struct nx1dPassStats {
+    int    dimension;       // dimension interpolated by the pass
+    double lines;           // number of solved 1D lines
+    double seconds;         // wall clock time
+    double bytes;           // bytes of the grids read and written
+    double cpu_seconds;     // CPU time of all threads
+    double cycles;
+    double instructions;
+    double cache_misses;
+} nx1dPassStats;
+
+// Error codes
+#define NX1D_SUCCESS            0
+#define NX1D_ERROR_MEMORY       1   // memory allocation failed
+#define NX1D_ERROR_GRID         2   // less than 3 points in a dimension, n_spline < 0 or n_values < 1
+#define NX1D_ERROR_ORDER        3   // pass order is no permutation of the dimensions
+#define NX1D_ERROR_ENGINE       4   // unknown coefficient engine
+#define NX1D_ERROR_ARGUMENT     5   // NULL plan or data array
+#define NX1D_ERROR_DIMENSION    6   // more than 10 dimensions for scattered point evaluation (16 for an update)
+#define NX1D_ERROR_PRECISION    7   // unknown precision mode or execute call of the wrong precision
+#define NX1D_ERROR_INDEX        8   // grid index of an update out of range
+#define NX1D_ERROR_SIZE         9   // interpolated grid exceeds the address space
+#define NX1D_ERROR_PAGES       10   // unknown page mode
+#define NX1D_ERROR_DERIVATIVES 11   // unknown derivative order or update of a plan with derivative output
+#define NX1D_ERROR_POINT       12   // non-finite coordinate of a scattered evaluation point
+
+// Coefficient engines of nx1dPlanSetEngine()
+#define NX1D_ENGINE_THOMAS  0       // Thomas algorithm with the tabulated LU factors (default)
+#define NX1D_ENGINE_FILTER  1       // causal and anti-causal recursive filter with the pole 2-sqrt(3)
+
+// Precision modes of nx1dPlanSetPrecision(), the float modes halve the
+//  memory of the grids and are executed by nx1dPlanExecuteFloat()
+#define NX1D_PRECISION_DOUBLE   0   // double storage and arithmetic (default)
+#define NX1D_PRECISION_FLOAT    1   // float storage and arithmetic
+#define NX1D_PRECISION_MIXED    2   // float storage, double arithmetic
+
+// Page modes of nx1dPlanSetPages(), used for the intermediate grids and the
+//  arrays of nx1dPlanAlloc(), which are first touched by the plan's threads
+#define NX1D_PAGES_DEFAULT      0   // transparent huge pages for large grids (default)
+#define NX1D_PAGES_SMALL        1   // base pages only
+#define NX1D_PAGES_HUGE         2   // explicit huge pages, transparent ones if the pool is too small
+
+int          nx1dPlanCreate(nx1dPlan ** plan, const int * nq, double dq, int dimension, int n_spline, int n_values);
+int          nx1dPlanExecute(nx1dPlan * plan, const double * v, double * out);
+int          nx1dPlanExecuteConsume(nx1dPlan * plan, double * v, double * out);
+int          nx1dPlanExecuteFloat(nx1dPlan * plan, const float * v, float * out);
+size_t       nx1dPlanPoints(const nx1dPlan * plan, int * nq_new);
+int          nx1dPlanGetThreads(const nx1dPlan * plan);
+int          nx1dPlanGetOrder(const nx1dPlan * plan, int * order);
+int          nx1dPlanPassTimes(const nx1dPlan * plan, double * seconds);
+int          nx1dPlanPassStats(const nx1dPlan * plan, nx1dPassStats * stats);
+int          nx1dPlanSetProfile(nx1dPlan * plan, int profile);
+int          nx1dPlanSetThreads(nx1dPlan * plan, int n_threads);
+int          nx1dPlanSetOrder(nx1dPlan * plan, const int * order);
+int          nx1dPlanSetEngine(nx1dPlan * plan, int engine);
+int          nx1dPlanSetPrecision(nx1dPlan * plan, int precision);
+int          nx1dPlanSetPages(nx1dPlan * plan, int pages);
+void       * nx1dPlanAlloc(const nx1dPlan * plan, size_t size);
+void         nx1dFree(void * data);
+void         nx1dPlanDestroy(nx1dPlan * plan);
+const char * nx1dErrorString(int error);
+
+// Scattered point evaluation:
+//  nx1dSplineCreate() computes the coefficients of the data v on the grid of
+//  plan once (2^dimension times the memory of v), nx1dSplineEvaluate() then
+//  evaluates the same spline as nx1dPlanExecute() at arbitrary points. Points
+//  outside of the grid are extrapolated from the nearest boundary cell, a
+//  NaN or infinite coordinate fails with NX1D_ERROR_POINT. The spline uses
+//  the threads and coefficient engine the plan is set up with.
+typedef struct nx1dSpline nx1dSpline;
+
+int          nx1dSplineCreate(nx1dSpline ** spline, nx1dPlan * plan, const double * v, const double * origin);
+int          nx1dSplineEvaluate(const nx1dSpline * spline, const double * x, int n_x, double * out);
+void         nx1dSplineDestroy(nx1dSpline * spline);
+
+// Incremental update:
+//  nx1dPlanUpdate() adds the interpolation of a sparse change of the input to
+//  a previous result out of the plan (double precision only). Change c moves
+//  the n_values values of the input point with the grid indices
+//  index[c*dimension ..] by delta[c*n_values ..]; the updated out agrees with
+//  nx1dPlanExecute() on the changed input up to rounding.
+int          nx1dPlanUpdate(nx1dPlan * plan, const int * index, const double * delta, int n_changes, double * out);
+
+// Derivative output:
+//  After nx1dPlanSetDerivatives(plan, order) with order 1 (gradient) or 2
+//  (gradient and diagonal of the Hessian) every interpolated point carries
+//  1 + order*dimension fields of n_values values, stored next to each other:
+//  the values, their first derivatives along dimension 0 .. dimension-1 and
+//  for order 2 their second derivatives along dimension 0 .. dimension-1.
+//  They are the analytic derivatives of the spline, evaluated in the same
+//  passes as the values, and apply to all execute calls (order 0, the
+//  default, writes the values only). Scattered point evaluation ignores
+//  the order, nx1dPlanUpdate() fails with NX1D_ERROR_DERIVATIVES.
+int          nx1dPlanSetDerivatives(nx1dPlan * plan, int order);
+
+// Pipelined execution:
+//  nx1dPlanExecuteBlocks() produces the interpolated grid of nx1dPlanExecute()
+//  in blocks of nx1dPlanBlockPoints(plan, block_points) points in index order
+//  (double precision only), so output can be written while later blocks are
+//  computed. acquire(data) provides the buffer of the next block (n_values
+//  doubles per field and point), release(block, n_points, data) receives it
+//  once it is computed. Both are called by the calling thread outside of
+//  parallel regions.
+typedef double * (*nx1dAcquireBlock)(void * data);
+typedef void     (*nx1dReleaseBlock)(double * block, size_t n_points, void * data);
+
+size_t       nx1dPlanBlockPoints(const nx1dPlan * plan, size_t block_points);
+int          nx1dPlanExecuteBlocks(nx1dPlan * plan, const double * v, size_t block_points,
+                                   nx1dAcquireBlock acquire, nx1dReleaseBlock release, void * data);
+
+// Single shot interpolation, replaces *v by the interpolated array (the
+//  original *v is freed, on failure *v is left untouched):
+//  nx1dInterpolate() returns NX1D_SUCCESS or an error code and stores the
+//  number of interpolated points to *nn_points (if not NULL).
+//  nx1dInterpolation() keeps the interface of the original function of the
+//  executable: it returns the number of interpolated points, or 0 if the
+//  interpolation failed or the result has more than INT_MAX points.
+int nx1dInterpolate(double ** v, const int * nq, double dq, int dimension, int n_spline, size_t * nn_points);
+int nx1dInterpolation(double ** v, int * nq_in, double dq, int dimension, int n_spline);
+
+#endif
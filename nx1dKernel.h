@@ -0,0 +1,562 @@
+// Interpolation kernels of one precision mode (see "Precision modes" in
+//  nx1dInterpolator.c). This file is included once per mode by
+//  nx1dInterpolator.c, which defines
+//
+//      NX1D_T(name)        name of the instance of a kernel, e.g. name##Float
+//      NX1D_STORE          element type of the input, output and intermediate grids
+//      NX1D_CALC           element type of the arithmetic
+//      NX1D_VEC            vector of NX1D_VLANES NX1D_CALC
+//      NX1D_VLANES         number of lines solved at once
+//      NX1D_CONVERT        1 if NX1D_STORE and NX1D_CALC differ (storage vector vmixed)
+//      NX1D_MATRIX_C       LU factors c'_i of the plan as NX1D_CALC
+//      NX1D_BASIS_T        columns of the basis matrix as NX1D_VEC
+//      NX1D_N_BASIS        number of NX1D_VEC per column of NX1D_BASIS_T
+//      NX1D_LANE_BASIS     basis matrices per lane as NX1D_VEC (see "Derivative output")
+//
+//  All of them are undefined at the end of this file.
+
+
+// load <width> consecutive entries into a vector, zero padding unused lanes
+static inline NX1D_VEC NX1D_T(nx1dLoad)(const NX1D_STORE * src, int width){
+
+    int s;
+    NX1D_VEC x;
+#if NX1D_CONVERT
+    vmixed y;
+#endif
+
+    if(width == NX1D_VLANES){
+#if NX1D_CONVERT
+        memcpy(&y, src, sizeof(vmixed));
+        x = __builtin_convertvector(y, NX1D_VEC);
+#else
+        memcpy(&x, src, sizeof(NX1D_VEC));
+#endif
+    }else{
+        x = (NX1D_VEC){0.0};
+        for(s = 0; s < width; ++s){
+            x[s] = src[s];
+        }
+    }
+    return x;
+}
+
+// store the first <width> lanes of a vector to consecutive entries
+static inline void NX1D_T(nx1dStore)(NX1D_STORE * dst, NX1D_VEC x, int width){
+
+    int s;
+#if NX1D_CONVERT
+    vmixed y;
+#endif
+
+    if(width == NX1D_VLANES){
+#if NX1D_CONVERT
+        y = __builtin_convertvector(x, vmixed);
+        memcpy(dst, &y, sizeof(vmixed));
+#else
+        memcpy(dst, &x, sizeof(NX1D_VEC));
+#endif
+    }else{
+        for(s = 0; s < width; ++s){
+            dst[s] = x[s];
+        }
+    }
+}
+
+
+// load <width> entries <stride> apart into a vector, zero padding unused lanes
+static inline NX1D_VEC NX1D_T(nx1dGather)(const NX1D_STORE * src, size_t stride, int width){
+
+    int s;
+    NX1D_VEC x = (NX1D_VEC){0.0};
+
+    for(s = 0; s < width; ++s){
+        x[s] = src[s * stride];
+    }
+    return x;
+}
+
+
+// Basis matrix micro-kernel (see "Basis matrix evaluation"): evaluate the
+//  polynomials a_i + b_i t + c_i t^2 + d_i t^3 of n_intervals intervals at the
+//  first n_eval rows of basis, the value of interval i at position j is stored
+//  to out + (i*stride + j)*jump
+static inline void NX1D_T(nx1dEvaluate)(const double * basis, const NX1D_VEC * inter_a, const NX1D_VEC * inter_b,
+                                        const NX1D_VEC * inter_c, const NX1D_VEC * inter_d, NX1D_STORE * out,
+                                        size_t jump, int stride, int n_intervals, int n_eval, int width){
+
+    int i, j;
+    NX1D_CALC t0, t1, t2, t3;
+
+    for(j = 0; j < n_eval; ++j){
+        t0 = basis[4*j];
+        t1 = basis[4*j+1];
+        t2 = basis[4*j+2];
+        t3 = basis[4*j+3];
+        for(i = 0; i < n_intervals; ++i){
+            NX1D_T(nx1dStore)(out + (size_t)(i*stride + j)*jump,
+                                inter_a[i] * t0
+                              + inter_b[i] * t1
+                              + inter_c[i] * t2
+                              + inter_d[i] * t3
+                              , width);
+        }
+    }
+}
+
+
+// Basis matrix micro-kernel with a basis matrix per lane (see "Derivative
+//  output"): like nx1dEvaluate, but the entries of row j of lane_basis are
+//  vectors holding the row of the basis matrix of every lane
+static inline void NX1D_T(nx1dEvaluateLanes)(const NX1D_VEC * lane_basis, const NX1D_VEC * inter_a,
+                                             const NX1D_VEC * inter_b, const NX1D_VEC * inter_c,
+                                             const NX1D_VEC * inter_d, NX1D_STORE * out, size_t jump, int stride,
+                                             int n_intervals, int n_eval, int width){
+
+    int i, j;
+    NX1D_VEC t0, t1, t2, t3;
+
+    for(j = 0; j < n_eval; ++j){
+        t0 = lane_basis[4*j];
+        t1 = lane_basis[4*j+1];
+        t2 = lane_basis[4*j+2];
+        t3 = lane_basis[4*j+3];
+        for(i = 0; i < n_intervals; ++i){
+            NX1D_T(nx1dStore)(out + (size_t)(i*stride + j)*jump,
+                                inter_a[i] * t0
+                              + inter_b[i] * t1
+                              + inter_c[i] * t2
+                              + inter_d[i] * t3
+                              , width);
+        }
+    }
+}
+
+
+// Lane basis of the lines m, m+1, ... of dimension k (see "Derivative
+//  output"), NULL if the plan has no derivative output
+static inline const NX1D_VEC * NX1D_T(nx1dLanes)(const nx1dPlan * plan, int k, size_t m){
+
+    return (plan->n_fields > 1) ? NX1D_LANE_BASIS(plan) + nx1dLaneOffset(plan, k, m) : NULL;
+}
+
+
+// Basis matrix micro-kernel of a single contiguous line: like nx1dEvaluate
+//  with jump = 1 and width = 1, but vectorized over the positions j using
+//  the columns basis_t of the basis matrix (n_basis vectors each)
+static inline void NX1D_T(nx1dEvaluateLine)(const NX1D_VEC * basis_t, int n_basis, const NX1D_VEC * inter_a,
+                                            const NX1D_VEC * inter_b, const NX1D_VEC * inter_c, const NX1D_VEC * inter_d,
+                                            NX1D_STORE * out, int stride, int n_intervals, int n_eval){
+
+    int i, j;
+    NX1D_CALC a, b, c, d;
+
+    for(i = 0; i < n_intervals; ++i){
+        a = inter_a[i][0];
+        b = inter_b[i][0];
+        c = inter_c[i][0];
+        d = inter_d[i][0];
+        for(j = 0; j < n_eval; j += NX1D_VLANES){
+            NX1D_T(nx1dStore)(out + i*stride + j,
+                                a * basis_t[              j / NX1D_VLANES]
+                              + b * basis_t[    n_basis + j / NX1D_VLANES]
+                              + c * basis_t[2 * n_basis + j / NX1D_VLANES]
+                              + d * basis_t[3 * n_basis + j / NX1D_VLANES]
+                              , (n_eval - j < NX1D_VLANES) ? (n_eval - j) : NX1D_VLANES);
+        }
+    }
+}
+
+
+// Start value w_0 of the causal sweep of the recursive filter engine from
+//  the d_j of the first NX1D_FILTER_TERMS+1 rows (see "Recursive filter
+//  engine"), the terms are summed from the smallest one on
+static inline NX1D_VEC NX1D_T(nx1dFilterStart)(const nx1dPlan * plan, const NX1D_VEC * d){
+
+    int j;
+    NX1D_VEC w = (NX1D_VEC){0.0};
+
+    for(j = NX1D_FILTER_TERMS; j >= 0; --j){
+        w += (NX1D_CALC)plan->filter_init[j] * d[j];
+    }
+    return w;
+}
+
+
+// Solve and interpolate <width> neighbouring 1D lines of length n:
+//  in and out point to the first entry of the first line, jump is the
+//  index difference between two entries of the same line on in and out,
+//  scratch points to the private scratch vectors of the calling thread,
+//  lane_basis is the lane basis of the lines or NULL (see nx1dLanes).
+static void NX1D_T(nx1dSolveLines)(const nx1dPlan * plan, NX1D_VEC * scratch,
+                                   const NX1D_STORE * in, NX1D_STORE * out, size_t jump, int n, int width,
+                                   const NX1D_VEC * lane_basis){
+
+// For better readability the parameters of the Thomas algorithm are
+//  prefixed with "matrix_" and the interpolation parameters are
+//  prefixed with "inter_"
+    int i, i_start, i_end;
+    int n_spline = plan->n_spline;
+    int filter   = (plan->engine == NX1D_ENGINE_FILTER && n > NX1D_FILTER_TERMS + 1);
+
+    const NX1D_CALC   scale    = plan->scale;
+    const NX1D_CALC   inv_dq   = plan->inv_dq;
+    const NX1D_CALC   inv_3dq  = plan->inv_3dq;
+    const NX1D_CALC   dq_3     = plan->dq_3;
+    const NX1D_CALC   pole     = plan->pole;
+    const NX1D_CALC * matrix_c = NX1D_MATRIX_C(plan);
+    NX1D_VEC * matrix_d = scratch;
+    NX1D_VEC * inter_b  = scratch;                  // overwrites d' once consumed
+    NX1D_VEC * inter_c  = scratch +     plan->maxdim_lines;
+    NX1D_VEC * inter_d  = scratch + 2 * plan->maxdim_lines;
+    NX1D_VEC * line     = scratch + 3 * plan->maxdim_lines;
+
+// gather the i-th entries of all lines into the lanes of line[i]
+    for(i = 0; i < n; ++i){
+        line[i] = NX1D_T(nx1dLoad)(in + i*jump, width);
+    }
+
+//----------------------------------------------------------------------
+//   Forward sweep   Forward sweep   Forward sweep   Forward sweep
+//----------------------------------------------------------------------
+// fill matrix_d array with tridiagonal matrix d elements and directly
+//  overwrite them with d' (the c' are taken from the plan). The filter
+//  engine needs the first d_j for its start value and then runs the causal
+//  filter in place (see "Recursive filter engine").
+    matrix_d[0] = (NX1D_VEC){0.0};
+    if(filter){
+        for(i = 1; i < n-1; ++i){
+            matrix_d[i] = scale * (line[i-1] - 2*line[i] + line[i+1]);
+        }
+        matrix_d[0] = NX1D_T(nx1dFilterStart)(plan, matrix_d);
+        for(i = 1; i < n-1; ++i){
+            matrix_d[i] = (matrix_d[i] - matrix_d[i-1]) * pole;
+        }
+    }else{
+        for(i = 1; i < n-1; ++i){
+            matrix_d[i] = scale * (line[i-1] - 2*line[i] + line[i+1]);
+            matrix_d[i] = (matrix_d[i] - matrix_d[i-1]) * matrix_c[i];
+        }
+    }
+
+
+//----------------------------------------------------------------------
+// Back substitution and interpolation in blocks of intervals
+//----------------------------------------------------------------------
+// the natural boundary c_{n-1} = 0 turns the solution of the last entry
+//  of the matrix problem into inter_c[n-2] = d'_{n-2}. The coefficients
+//  of a block of NX1D_EVAL_BLOCK intervals are determined from back to
+//  front and the block is evaluated at n_spline+1 positions right away.
+    inter_c[n-1] = (NX1D_VEC){0.0};
+    for(i_end = n-1; i_end > 0; i_end = i_start){
+
+        i_start = (i_end > NX1D_EVAL_BLOCK) ? i_end - NX1D_EVAL_BLOCK : 0;
+
+        for(i = i_end-1; i >= i_start; --i){
+
+        // solve the matrix problem from back to front
+            inter_c[i] = matrix_d[i] - (filter ? pole : matrix_c[i]) * inter_c[i+1];
+
+        // calculate inter_b and inter_d values from inter_c
+            inter_d[i] = (inter_c[i+1] - inter_c[i]) * inv_3dq;
+            inter_b[i] = (line[i+1] - line[i]) * inv_dq - dq_3 * (2 * inter_c[i] + inter_c[i+1]);
+        }
+
+    // interpolation procedure
+        if(lane_basis != NULL){
+            NX1D_T(nx1dEvaluateLanes)(lane_basis, line + i_start, inter_b + i_start, inter_c + i_start,
+                                      inter_d + i_start, out + (size_t)i_start*(n_spline+1)*jump, jump, n_spline+1,
+                                      i_end - i_start, n_spline+1, width);
+        }else if(jump == 1){
+            NX1D_T(nx1dEvaluateLine)(NX1D_BASIS_T(plan), NX1D_N_BASIS(plan), line + i_start, inter_b + i_start,
+                                     inter_c + i_start, inter_d + i_start, out + i_start*(n_spline+1),
+                                     n_spline+1, i_end - i_start, n_spline+1);
+        }else{
+            NX1D_T(nx1dEvaluate)(plan->basis, line + i_start, inter_b + i_start, inter_c + i_start, inter_d + i_start,
+                                 out + (size_t)i_start*(n_spline+1)*jump, jump, n_spline+1, i_end - i_start, n_spline+1, width);
+        }
+    }
+
+// end point of the last interval (last row of the basis matrix)
+    if(lane_basis != NULL){
+        NX1D_T(nx1dEvaluateLanes)(lane_basis + 4*(n_spline+1), line + n-2, inter_b + n-2, inter_c + n-2,
+                                  inter_d + n-2, out + (size_t)(n-1)*(n_spline+1)*jump, jump, n_spline+1, 1, 1, width);
+    }else{
+        NX1D_T(nx1dEvaluate)(plan->basis + 4*(n_spline+1), line + n-2, inter_b + n-2, inter_c + n-2, inter_d + n-2,
+                             out + (size_t)(n-1)*(n_spline+1)*jump, jump, n_spline+1, 1, 1, width);
+    }
+}
+
+
+// Solve and interpolate <width> (at most tile_width) neighbouring lines of
+//  a strided pass via a contiguous tile, arguments as for nx1dSolveLines
+//  plus the number of interpolated entries n_new, the dimension k and the
+//  index m of the first line (for its lane basis)
+static void NX1D_T(nx1dSolveTile)(const nx1dPlan * plan, NX1D_VEC * scratch,
+                                  const NX1D_STORE * in, NX1D_STORE * out, size_t jump, int n, int n_new, int width,
+                                  int k, size_t m){
+
+    int i, s;
+    int tile_width  = plan->tile_width;
+    NX1D_STORE * tile_in  = (NX1D_STORE*)(scratch + 4 * plan->maxdim_lines);
+    NX1D_STORE * tile_out = tile_in + (size_t)plan->maxdim_lines * tile_width;
+
+// gather
+    for(i = 0; i < n; ++i){
+        memcpy(tile_in + (size_t)i * tile_width, in + (size_t)i * jump, width * sizeof(NX1D_STORE));
+    }
+
+// solve the lines of the tile in groups of NX1D_VLANES
+    for(s = 0; s < width; s += NX1D_VLANES){
+        NX1D_T(nx1dSolveLines)(plan, scratch, tile_in + s, tile_out + s, tile_width, n,
+                               (width - s < NX1D_VLANES) ? (width - s) : NX1D_VLANES, NX1D_T(nx1dLanes)(plan, k, m + s));
+    }
+
+// scatter
+    for(i = 0; i < n_new; ++i){
+        memcpy(out + (size_t)i * jump, tile_out + (size_t)i * tile_width, width * sizeof(NX1D_STORE));
+    }
+}
+
+
+// Chunk local solutions y (see "Long lines") of <width> chunks of a long
+//  line, one chunk per lane: chunk s starts at the unknown first + s*m and
+//  has m unknowns, except for the last chunk of the line which has <length>.
+//  in points to the first entry of the line, y is stored to c.
+static void NX1D_T(nx1dSolveChunks)(const nx1dPlan * plan, NX1D_VEC * scratch, const NX1D_STORE * in, NX1D_CALC * c,
+                                    size_t jump, int first, int m, int length, int width){
+
+    int i, s;
+    int filter = (plan->engine == NX1D_ENGINE_FILTER && m > NX1D_FILTER_TERMS + 1);
+    size_t stride = (size_t)m * jump;
+    NX1D_VEC prev, cur, next, y;
+    NX1D_VEC * matrix_d = scratch;
+    const NX1D_CALC   scale    = plan->scale;
+    const NX1D_CALC   pole     = plan->pole;
+    const NX1D_CALC * matrix_c = NX1D_MATRIX_C(plan);
+
+// forward sweep, the first row of the line keeps the boundary d_0 = 0
+    y = (NX1D_VEC){0.0};
+    for(s = 0; s < width; ++s){
+        i = first + s*m;
+        if(i > 0){
+            y[s] = scale * ((NX1D_CALC)in[(size_t)(i-1)*jump] - 2*(NX1D_CALC)in[(size_t)i*jump]
+                            + (NX1D_CALC)in[(size_t)(i+1)*jump]);
+        }
+    }
+    matrix_d[0] = filter ? y : y * matrix_c[0];
+
+    cur  = NX1D_T(nx1dGather)(in + (size_t)first*jump,     stride, width);
+    next = NX1D_T(nx1dGather)(in + (size_t)(first+1)*jump, stride, width);
+    for(i = 1; i < length; ++i){
+        prev = cur;
+        cur  = next;
+        next = NX1D_T(nx1dGather)(in + (size_t)(first+i+1)*jump, stride, width);
+
+        matrix_d[i] = scale * (prev - 2*cur + next);
+        if(!filter){
+            matrix_d[i] = (matrix_d[i] - matrix_d[i-1]) * matrix_c[i];
+        }
+    }
+
+// causal sweep of the filter engine, the first row of every chunk is a
+//  boundary row as in nx1dSolveLines (see "Recursive filter engine")
+    if(filter){
+        matrix_d[0] = NX1D_T(nx1dFilterStart)(plan, matrix_d);
+        for(i = 1; i < length; ++i){
+            matrix_d[i] = (matrix_d[i] - matrix_d[i-1]) * pole;
+        }
+    }
+
+// back substitution, rows beyond m only exist for the last chunk
+    y = (NX1D_VEC){0.0};
+    for(i = length-1; i >= m; --i){
+        y = matrix_d[i] - (filter ? pole : matrix_c[i]) * y;
+        c[first + (width-1)*m + i] = y[width-1];
+    }
+    for(s = 0; s < width-1; ++s){
+        y[s] = 0.0;
+    }
+    for(i = m-1; i >= 0; --i){
+        y = matrix_d[i] - (filter ? pole : matrix_c[i]) * y;
+        for(s = 0; s < width; ++s){
+            c[first + s*m + i] = y[s];
+        }
+    }
+}
+
+
+// Solve and interpolate a single long line of n points by splitting it
+//  into chunks (see "Long lines"), arguments as for nx1dSolveLines.
+//  Called outside of a parallel region, all threads of the plan are used.
+static void NX1D_T(nx1dSolveLong)(const nx1dPlan * plan, const NX1D_STORE * in, NX1D_STORE * out, size_t jump, int n,
+                                  const NX1D_VEC * lane_basis){
+
+    int g, q, i, i_start, s, e, width;
+    int n_spline = plan->n_spline;
+    int n_chunks = nx1dLongChunks(plan, plan->n_threads, n);
+    int n_groups = (n_chunks + NX1D_VLANES - 1) / NX1D_VLANES;
+    int m        = (n - 1) / n_chunks;
+    NX1D_CALC aux;
+    NX1D_CALC * c     = (NX1D_CALC*)plan->long_c;
+    NX1D_CALC * left  = c + plan->maxdim;               // c_{s-1} of chunk q
+    NX1D_CALC * right = left + n_chunks;                // c_e of chunk q
+    const NX1D_CALC u0 = plan->spike[0];
+    NX1D_VEC inter_a[NX1D_EVAL_BLOCK], inter_b[NX1D_EVAL_BLOCK];
+    NX1D_VEC inter_c[NX1D_EVAL_BLOCK], inter_d[NX1D_EVAL_BLOCK];
+
+    c[n-1] = 0.0;
+
+#ifdef _OPENMP
+    #pragma omp parallel num_threads(plan->n_threads) \
+                         private(g, q, i, i_start, s, e, width, aux, inter_a, inter_b, inter_c, inter_d)
+#endif
+    {
+// 1. chunk local solutions, NX1D_VLANES chunks per group
+#ifdef _OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for(g = 0; g < n_groups; ++g){
+        width = (n_chunks - g*NX1D_VLANES < NX1D_VLANES) ? (n_chunks - g*NX1D_VLANES) : NX1D_VLANES;
+        NX1D_T(nx1dSolveChunks)(plan, (NX1D_VEC*)(plan->scratch + nx1dThreadNum() * plan->n_scratch), in, c, jump,
+                                g*NX1D_VLANES*m, m, (g == n_groups-1) ? (n-1) - (n_chunks-1)*m : m, width);
+    }
+
+// 2. the two values at the boundary between chunk q-1 and q
+#ifdef _OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for(q = 1; q < n_chunks; ++q){
+        s   = q*m;
+        aux = (c[s-1] + u0 * c[s]) / (1 - u0 * u0);
+        right[q-1] = c[s] + u0 * aux;
+        left[q]    = aux;
+    }
+
+// 3. add the responses to the neighbouring chunks
+#ifdef _OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for(q = 0; q < n_chunks; ++q){
+        s = q*m;
+        e = (q == n_chunks-1) ? n-1 : s + m;
+        for(i = 0; i < NX1D_SPIKE_LENGTH; ++i){
+            if(q > 0)          c[s + i]     += left[q]  * (NX1D_CALC)plan->spike[i];
+            if(q < n_chunks-1) c[e - 1 - i] += right[q] * (NX1D_CALC)plan->spike[i];
+        }
+    }
+
+// 4. interpolation of the intervals of each chunk
+#ifdef _OPENMP
+    #pragma omp for schedule(static)
+#endif
+    for(q = 0; q < n_chunks; ++q){
+        s = q*m;
+        e = (q == n_chunks-1) ? n-1 : s + m;
+        for(i_start = s, width = 0; i_start < e; i_start += NX1D_EVAL_BLOCK){
+
+            width = (e - i_start < NX1D_EVAL_BLOCK) ? (e - i_start) : NX1D_EVAL_BLOCK;
+            for(g = 0; g < width; ++g){
+                i = i_start + g;
+                inter_a[g] = (NX1D_VEC){in[(size_t)i*jump]};
+                inter_c[g] = (NX1D_VEC){c[i]};
+                inter_d[g] = (NX1D_VEC){(c[i+1] - c[i]) * (NX1D_CALC)plan->inv_3dq};
+                inter_b[g] = (NX1D_VEC){((NX1D_CALC)in[(size_t)(i+1)*jump] - (NX1D_CALC)in[(size_t)i*jump])
+                                        * (NX1D_CALC)plan->inv_dq - (NX1D_CALC)plan->dq_3 * (2 * c[i] + c[i+1])};
+            }
+
+            if(lane_basis != NULL){
+                NX1D_T(nx1dEvaluateLanes)(lane_basis, inter_a, inter_b, inter_c, inter_d,
+                                          out + (size_t)i_start*(n_spline+1)*jump, jump, n_spline+1, width, n_spline+1, 1);
+            }else if(jump == 1){
+                NX1D_T(nx1dEvaluateLine)(NX1D_BASIS_T(plan), NX1D_N_BASIS(plan), inter_a, inter_b, inter_c, inter_d,
+                                         out + (size_t)i_start*(n_spline+1), n_spline+1, width, n_spline+1);
+            }else{
+                NX1D_T(nx1dEvaluate)(plan->basis, inter_a, inter_b, inter_c, inter_d,
+                                     out + (size_t)i_start*(n_spline+1)*jump, jump, n_spline+1, width, n_spline+1, 1);
+            }
+        }
+
+    // end point of the last interval (last row of the basis matrix)
+        if(q == n_chunks-1 && lane_basis != NULL){
+            NX1D_T(nx1dEvaluateLanes)(lane_basis + 4*(n_spline+1), inter_a + width-1, inter_b + width-1,
+                                      inter_c + width-1, inter_d + width-1,
+                                      out + (size_t)(n-1)*(n_spline+1)*jump, jump, n_spline+1, 1, 1, 1);
+        }else if(q == n_chunks-1){
+            NX1D_T(nx1dEvaluate)(plan->basis + 4*(n_spline+1), inter_a + width-1, inter_b + width-1,
+                                 inter_c + width-1, inter_d + width-1,
+                                 out + (size_t)(n-1)*(n_spline+1)*jump, jump, n_spline+1, 1, 1, 1);
+        }
+    }
+    }
+}
+
+
+// Interpolate dimension k in pass p: the d_jump*jump lines of src (see
+//  nx1dExecute for the geometry) are written to dst
+static void NX1D_T(nx1dPass)(const nx1dPlan * plan, int p, int k, size_t jump, size_t d_jump,
+                             const NX1D_STORE * src, NX1D_STORE * dst){
+
+    size_t l, m, g;
+    int width;
+    size_t n_groups;
+    int group_width;      // number of lines per group, NX1D_VLANES or tile_width
+    int tiled;            // 1 if the lines of the current pass are processed in tiles
+    size_t offset       = plan->nq[k]     * jump;   // offset added after each <d_jump> position
+    size_t inter_offset = plan->nq_new[k] * jump;   // offset on the new interpolated array
+
+// passes with too few lines for all lanes and threads split their
+//  lines into chunks (see "Long lines")
+    if(plan->solve_long[p]){
+        for(g = 0; g < d_jump * jump; ++g){
+            l = g / jump;
+            m = g % jump;
+            NX1D_T(nx1dSolveLong)(plan, src + m + l*offset, dst + m + l*inter_offset, jump, plan->nq[k],
+                                  NX1D_T(nx1dLanes)(plan, k, m));
+        }
+        return;
+    }
+
+// strided passes are processed in tiles of tile_width lines (see
+//  "Tiled passes"), all others in groups of NX1D_VLANES lines
+    tiled       = ((size_t)jump * sizeof(NX1D_STORE) >= NX1D_PAGE_SIZE);
+    group_width = tiled ? plan->tile_width : NX1D_VLANES;
+
+// the d_jump*n_groups groups of lines are distributed in contiguous
+//  chunks over the threads, the implicit barrier at the end of the
+//  loop completes the dimension
+    n_groups = (jump + group_width - 1) / group_width;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(plan->n_threads) schedule(static) private(l, m, width)
+#endif
+    for(g = 0; g < d_jump * n_groups; ++g){
+
+        l = g / n_groups;
+        m = g % n_groups * group_width;
+
+        width = (jump - m < (size_t)group_width) ? (int)(jump - m) : group_width;
+
+        if(tiled){
+            NX1D_T(nx1dSolveTile)(plan, (NX1D_VEC*)(plan->scratch + nx1dThreadNum() * plan->n_scratch),
+                                  src + m + l*offset, dst + m + l*inter_offset, jump, plan->nq[k], plan->nq_new[k], width,
+                                  k, m);
+        }else{
+            NX1D_T(nx1dSolveLines)(plan, (NX1D_VEC*)(plan->scratch + nx1dThreadNum() * plan->n_scratch),
+                                   src + m + l*offset, dst + m + l*inter_offset, jump, plan->nq[k], width,
+                                   NX1D_T(nx1dLanes)(plan, k, m));
+        }
+    }
+}
+
+
+#undef NX1D_T
+#undef NX1D_STORE
+#undef NX1D_CALC
+#undef NX1D_VEC
+#undef NX1D_VLANES
+#undef NX1D_CONVERT
+#undef NX1D_MATRIX_C
+#undef NX1D_BASIS_T
+#undef NX1D_N_BASIS
+#undef NX1D_LANE_BASIS
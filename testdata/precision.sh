@@ -0,0 +1,43 @@
+#!/bin/bash
+# Interpolation error of the precision modes (-P) on the analytic sinc grids:
+#  the coarse grids are interpolated with n_spline = 1 and compared to the
+#  analytic values of the refined grids, reporting rmsd and maximum deviation
+#
+#   usage: precision.sh [executable] [modes]
+
+exe=${1:-"$(dirname $0)/../bin/nx1d-interpolator"}
+modes=${2:-"double mixed float"}
+dir=$(dirname $0)
+
+for test in "2 2D/2d_sinc_12_7_analytic.dat 2D/2d_sinc_23_13_analytic.dat" \
+            "3 3D/3d_sinc_12_7_9_analytic.dat 3D/3d_sinc_23_13_17_analytic.dat"; do
+
+    set -- $test
+    dimension=$1
+    input=$dir/$2
+    analytic=$dir/$3
+
+    printf "\n%s\n" "$2"
+    for mode in $modes; do
+
+        paste <(grep -v "\(^\s*#\|^\s*$\|^N\)" $analytic) \
+              <($exe -c -P $mode $input $dimension 1 | grep -v "\(^\s*$\|^N\)") | awk '
+
+            BEGIN{
+                sum_sd = 0
+                max_d  = 0
+            }
+
+            {
+                d = $'$((dimension + 1))' - $'$((dimension + 2))'
+                sum_sd += d*d
+                if(d < 0) d = -d
+                if(d > max_d) max_d = d
+            }
+
+            END{
+                printf "\t%-8s rmsd % e    max % e\n", "'$mode'", sqrt(sum_sd / NR), max_d
+            }'
+    done
+done
+printf "\n"